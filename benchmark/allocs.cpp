@@ -0,0 +1,43 @@
+/*************************************************************************\
+*   Allocation counter of benchmark (based on BNFlite)                    *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Global operator new and delete are replaced in their own unit: inlined into    */
+/* the benchmark, delete with free() is warned as mismatched with new expression */
+
+#include <stdlib.h>
+#include <new>
+
+size_t allocs = 0; // number of allocations since the start
+
+void* operator new(size_t size)
+{
+    allocs++;
+    void* ptr = malloc(size? size: 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
@@ -0,0 +1,108 @@
+/*************************************************************************\
+*   Benchmark of AnalyzeBatch: throughput against number of threads       *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build: g++ -std=c++11 -O2 -pthread -I.. batch.cpp -o batch             */
+/* Usage: batch [number of records] [max number of threads]                */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+using namespace bnf;
+
+
+typedef Interface<double> Calc;
+
+static Calc DoNumber(std::vector<Calc>& res)
+{
+    return Calc(strtod(res[0].text, 0), res);
+}
+
+static Calc DoBinary(std::vector<Calc>& res)
+{
+    double value = res[0].data;
+    for (unsigned int i = 1; i < res.size(); i += 2) {
+        switch(*res[i].text) {
+            case '+': value += res[i + 1].data; break;
+            case '-': value -= res[i + 1].data; break;
+            case '*': value *= res[i + 1].data; break;
+            case '/': value /= res[i + 1].data; break;
+        }
+    }
+    return Calc(value, res);
+}
+
+static Calc DoBracket(std::vector<Calc>& res)
+{
+    return *res[0].text == '('? res[1] : res[0];
+}
+
+/* short formula record like "(12 + x3) * 4.5 - 7" */
+static std::string Record(int depth)
+{
+    char buf[16];
+    switch (rand() % (depth > 3? 2: 5)) {
+    case 0: sprintf(buf, "%d", rand() % 1000); return buf;
+    case 1: sprintf(buf, "%d.%d", rand() % 100, rand() % 10); return buf;
+    case 2: return "(" + Record(depth + 1) + ")";
+    default: return Record(depth + 1) + " +-*/"[1 + rand() % 4] + Record(depth + 1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t num = argc > 1? atoi(argv[1]): 200000;
+    unsigned int max = argc > 2? atoi(argv[2]): std::thread::hardware_concurrency();
+
+    Token digit("0123456789");
+    Lexem number_ = 1*digit + !("." + 1*digit);
+    Rule number = number_;
+    Rule expression;
+    Rule primary = ("(" + expression + ")") | number;
+    Rule mul = primary + *("*/" + primary);
+    expression = mul + *("+-" + mul);
+    Bind(number, DoNumber);
+    Bind(primary, DoBracket);
+    Bind(mul, DoBinary);
+    Bind(expression, DoBinary);
+    Program program(expression);
+
+    std::vector<std::string> records;
+    std::vector<const char*> inputs;
+    size_t bytes = 0;
+    for (size_t i = 0; i < num; i++) {
+        records.push_back(Record(0));
+        bytes += records.back().size(); }
+    for (size_t i = 0; i < num; i++) {
+        inputs.push_back(records[i].c_str()); }
+
+    std::vector< Result<Calc> > results;
+    double base = 0;
+    printf("%zu records, %.1f MB\n", num, bytes / 1e6);
+    for (unsigned int threads = 1; threads <= (max? max: 1); threads *= 2) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        size_t err = AnalyzeBatch(program, inputs, results, threads);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!base) base = num / sec;
+        printf("threads %3u: %10.0f records/s %7.1f MB/s  speedup %5.2f  errors %zu\n",
+            threads, num / sec, bytes / sec / 1e6, num / sec / base, err);
+    }
+    expression = Null();  // disjoin Rule recursion to safe Rules removal
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*************************************************************************\
+*   Benchmark of bundled grammars on generated corpora                    *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build in benchmark directory (formula grammar is linked from its sources):       */
+/*   g++ -std=c++14 -O2 -I.. bench.cpp allocs.cpp ../formula_compiler/parser.cpp \  */
+/*       ../formula_compiler/code_gen.cpp ../formula_compiler/code_lib.cpp -o bench  */
+/* Usage: bench [-min size] [-max size] [-o result.csv] [-slope limit] [grammar...]  */
+/*    size can have K or M suffix (default 1K..4M), grammars: json c_xprs formula ini cfg cmd */
+/* Each grammar parses corpora doubled in size from min to max, it prints MB/s, records/s, us/call, */
+/* allocations and peak RSS of parsing, then checks that time grows not faster than */
+/* size^limit (default 1.3); the exit code is not zero for parsing errors or such growth */
+
+#include "../tutorial/jsonlite.h"
+#include "../c_xprs/c_xprs.h"
+#include "../formula_compiler/byte_code.h"
+#include "../examples/ini.h"
+#include "../examples/cfg.h"
+#include "../examples/cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <sstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+std::list<byte_code> bnflite_byte_code(std::string expr); // formula_compiler/parser.cpp
+extern size_t allocs; // allocs.cpp: number of allocations since the start
+
+
+static long PeakRSS(bool reset) // KB, reset is possible on Linux only
+{
+#if defined(__linux__)
+    FILE* f = fopen(reset? "/proc/self/clear_refs": "/proc/self/status", reset? "w": "r");
+    long kb = 0; char line[128];
+    if (f && reset) fputs("5", f);
+    while (f && !reset && fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "VmHWM:", 6)) kb = atol(line + 6); }
+    if (f) fclose(f);
+    if (kb || reset) return kb;
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage ru; getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+static unsigned int seed = 1; // own generator to get the same corpora on all platforms
+static unsigned int Rand(unsigned int n)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % n;
+}
+
+static std::string Num(unsigned int n)
+{
+    char buf[16]; sprintf(buf, "%u", Rand(n)); return buf;
+}
+
+
+/* JSON: records in arrays of 1000 (jsonlite arrays are limited by maxRepeate) */
+static size_t MakeJson(size_t bytes, std::vector<std::string>& texts)
+{
+    std::string text = "{\"records\":[";
+    size_t num = 0;
+    while (text.size() < bytes) {
+        text += num? ",[": "[";
+        for (int i = 0; i < 1000 && text.size() < bytes; i++, num++) {
+            text += i? ",": "";
+            text += "{\"id\":" + Num(100000) + ",\"name\":\"item " + Num(1000) + "\",\"price\":"
+                + Num(100) + "." + Num(100) + "e1,\"tags\":[\"a\",\"b\\n\"],\"ok\":true,\"next\":null}"; }
+        text += "]"; }
+    texts.push_back(text + "]}");
+    return num;
+}
+
+static bool ParseJson(const std::string& text)
+{
+    int status = 0;
+    Repo::ParseJSON(text.c_str(), &status);
+    return status > 0;
+}
+
+
+/* C expressions of c_xprs one per record */
+static std::string Xprs(int depth)
+{
+    static const char* ops[] = { "+", "-", "*", "&", "|", "^", "==", "!=", "<", ">", "&&", "||", "<<" };
+    switch (Rand(depth > 2? 2: 6)) {
+    case 0: return Num(100);
+    case 1: return "0x" + Num(10) + "F";
+    case 2: return "(" + Xprs(depth + 1) + ")";
+    case 3: return "-(" + Xprs(depth + 1) + ")"; // "--" is decrement
+    case 4: return Xprs(depth + 1) + "? " + Xprs(depth + 1) + ": " + Xprs(depth + 1);
+    default: return Xprs(depth + 1) + " " + ops[Rand(sizeof(ops)/sizeof(ops[0]))] + " " + Xprs(depth + 1);
+    }
+}
+
+static size_t MakeXprs(size_t bytes, std::vector<std::string>& texts)
+{
+    for (size_t size = 0; size < bytes; size += texts.back().size()) {
+        texts.push_back(Xprs(0)); }
+    return texts.size();
+}
+
+static bool ParseXprs(const std::string& text)
+{
+    static C_Xprs gramma;
+    int value;
+    return gramma.Evaluate(text.c_str(), value);
+}
+
+
+/* formulas of formula_compiler one per record */
+static std::string Formula(int depth)
+{
+    switch (Rand(depth > 2? 2: 5)) {
+    case 0: return Num(1000);
+    case 1: return Num(100) + "." + Num(100);
+    case 2: return "(" + Formula(depth + 1) + ")";
+    case 3: return "POW(" + Formula(depth + 1) + ", " + Formula(depth + 1) + ")";
+    default: return Formula(depth + 1) + " +-*/"[1 + Rand(4)] + Formula(depth + 1);
+    }
+}
+
+static size_t MakeFormula(size_t bytes, std::vector<std::string>& texts)
+{
+    for (size_t size = 0; size < bytes; size += texts.back().size()) {
+        texts.push_back(Formula(0)); }
+    return texts.size();
+}
+
+static bool ParseFormula(const std::string& text)
+{
+    return bnflite_byte_code(text).size() != 0;
+}
+
+
+/* ini file of examples/ini.h */
+static size_t MakeIni(size_t bytes, std::vector<std::string>& texts)
+{
+    std::string text;
+    size_t num = 0;
+    while (text.size() < bytes) {
+        text += "; section " + Num(1000) + "\n[ section" + Num(1000) + " ]\n";
+        for (int i = 0; i < 16; i++, num++) {
+            text += "key" + Num(100) + " = value " + Num(100000) + " of key\n"; }
+        text += "\n"; }
+    texts.push_back(text);
+    return num;
+}
+
+static bool ParseIni(const std::string& text)
+{
+    static Grammar gramma([](Rule& root) { IniGramma(root); });
+    return Analyze(gramma, text.c_str(), 0, ini_zero_parse) > 0;
+}
+
+
+/* xml-like configuration of examples/cfg.h */
+static size_t MakeCfg(size_t bytes, std::vector<std::string>& texts)
+{
+    static const char* types[] = { "memory", "cpu", "processes", "disk" };
+    std::string text;
+    size_t num = 0;
+    while (text.size() < bytes) {
+        text += "<client key=\"" + Num(100000) + "\" mail=\"user" + Num(1000) + "@mail.com\">\n";
+        for (int i = 0; i < 4; i++, num++) {
+            text += "  <alert type=\"" + std::string(types[i]) + "\" limit=\"" + Num(100) + "%\" />\n"; }
+        text += "</client>\n"; }
+    texts.push_back(text);
+    return num;
+}
+
+static bool ParseCfg(const std::string& text)
+{
+    static Grammar gramma([](Rule& root) { CfgGramma(root); });
+    return Analyze(gramma, text.c_str()) > 0;
+}
+
+
+/* ffmpeg filter chains of examples/cmd.h one per record */
+static size_t MakeCmd(size_t bytes, std::vector<std::string>& texts)
+{
+    static const char* filters[] = { "scale=640:480", "crop=100:100:0:0", "amerge", "volume=0.5", "null" };
+    for (size_t size = 0; size < bytes; size += texts.back().size()) {
+        std::string text;
+        for (unsigned int i = 0, n = 1 + Rand(5); i < n; i++) {
+            text += i? ", [l" + Num(10) + "]": "[in]";
+            text += filters[Rand(sizeof(filters)/sizeof(filters[0]))];
+            text += "[l" + Num(10) + "]"; }
+        texts.push_back(text); }
+    return texts.size();
+}
+
+static bool ParseCmd(const std::string& text)
+{
+    static Grammar gramma([](Rule& root) { CmdGramma(root); });
+    return Analyze(gramma, text.c_str()) > 0;
+}
+
+
+static const struct Workload
+{
+    const char* name;
+    size_t (*make)(size_t bytes, std::vector<std::string>& texts); // returns number of records
+    bool (*parse)(const std::string& text);
+} workloads[] = {
+    { "json", MakeJson, ParseJson },
+    { "c_xprs", MakeXprs, ParseXprs },
+    { "formula", MakeFormula, ParseFormula },
+    { "ini", MakeIni, ParseIni },
+    { "cfg", MakeCfg, ParseCfg },
+    { "cmd", MakeCmd, ParseCmd }
+};
+
+static size_t Size(const char* arg)
+{
+    char* end; size_t size = strtoul(arg, &end, 10);
+    return size << (*end == 'K' || *end == 'k'? 10: *end == 'M' || *end == 'm'? 20: 0);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t min = 1 << 10, max = 4 << 20;
+    double limit = 1.3;
+    FILE* csv = 0;
+    std::vector<const Workload*> run;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-min") && i + 1 < argc) min = Size(argv[++i]);
+        else if (!strcmp(argv[i], "-max") && i + 1 < argc) max = Size(argv[++i]);
+        else if (!strcmp(argv[i], "-slope") && i + 1 < argc) limit = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) csv = fopen(argv[++i], "w");
+        else for (size_t j = 0; j < sizeof(workloads)/sizeof(workloads[0]); j++) {
+            if (!strcmp(argv[i], workloads[j].name)) run.push_back(&workloads[j]); } }
+    for (size_t j = 0, all = !run.size(); j < sizeof(workloads)/sizeof(workloads[0]) && all; j++) {
+        run.push_back(&workloads[j]); }
+    if (csv) fprintf(csv, "grammar,bytes,records,seconds,mb_per_s,records_per_s,us_per_call,allocs,peak_rss_kb\n");
+
+    int errors = 0;
+    std::stringstream mute; // formula_compiler and c_xprs print their results
+    for (size_t j = 0; j < run.size(); j++) {
+        double sx = 0, sy = 0, sxx = 0, sxy = 0; int points = 0;
+        for (size_t size = min; size <= max; size *= 2) {
+            std::vector<std::string> texts; seed = 1;
+            size_t records = run[j]->make(size, texts), bytes = 0, failed = 0, count = 0;
+            for (size_t i = 0; i < texts.size(); i++) {
+                bytes += texts[i].size(); }
+            double best = 0, total = 0;
+            long rss = PeakRSS(true);
+            std::streambuf* out = std::cout.rdbuf(mute.rdbuf());
+            for (int k = 0; k < 20 && (total < 0.2 || !k); k++) { // the best of several runs for small sizes
+                size_t org = allocs;
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < texts.size(); i++) {
+                    failed += !run[j]->parse(texts[i]); }
+                double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                count = allocs - org; total += sec;
+                if (!k || sec < best) best = sec;
+                mute.str(""); }
+            std::cout.rdbuf(out);
+            rss = PeakRSS(false);
+            errors += failed != 0;
+            printf("%-8s %10zu bytes %8zu records %9.4f s %8.2f MB/s %10.0f records/s %9.2f us/call %9zu allocs %7ld KB%s\n",
+                run[j]->name, bytes, records, best, bytes / best / 1e6, records / best, best / texts.size() * 1e6, count, rss,
+                failed? " PARSING ERRORS": "");
+            if (csv) fprintf(csv, "%s,%zu,%zu,%.6f,%.3f,%.1f,%.3f,%zu,%ld\n",
+                run[j]->name, bytes, records, best, bytes / best / 1e6, records / best, best / texts.size() * 1e6, count, rss);
+            if (best > 0.005) { // shorter times are too noisy to estimate growth
+                double x = log((double)bytes), y = log(best);
+                sx += x; sy += y; sxx += x * x; sxy += x * y; points++; } }
+        if (points > 1) {
+            double slope = (points * sxy - sx * sy) / (points * sxx - sx * sx);
+            printf("%-8s time grows as size^%.2f%s\n\n", run[j]->name, slope, slope > limit? " SUPER-LINEAR": "");
+            errors += slope > limit; }
+        else printf("%-8s too fast to estimate growth, increase -max\n\n", run[j]->name); }
+    if (csv) fclose(csv);
+    return errors;
+}
@@ -0,0 +1,166 @@
+/*************************************************************************\
+*   Benchmark of parsing events and tree against Interface results        *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build: g++ -std=c++11 -O2 -I.. events.cpp -o events                     */
+/* Usage: events [number of records] [number of runs]                      */
+/* Extracts number of values and sum of "price" members of JSON document:  */
+/* by callbacks with Interface results, by AnalyzeEvents to a Sink and by  */
+/* visit of Tree of AnalyzeTree;                                           */
+/* results must be the same                                                */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+using namespace bnf;
+
+
+struct Total
+{
+    int values;
+    double price;
+    Total(): values(0), price(0) {};
+};
+typedef Interface<Total> Tot;
+
+static bool Price(const char* text, size_t len) // text of lexem includes blanks before it
+{
+    return len >= 7 && !strncmp(text + len - 7, "\"price\"", 7);
+}
+
+static Tot DoSum(std::vector<Tot>& res)
+{
+    Tot t(Total(), res);
+    for (size_t i = 0; i < res.size(); i++) {
+        t.data.values += res[i].data.values; t.data.price += res[i].data.price; }
+    return t;
+}
+
+static Tot DoValue(std::vector<Tot>& res)
+{
+    Tot t = DoSum(res);
+    t.data.values++;
+    return t;
+}
+
+static Tot DoMember(std::vector<Tot>& res) // key, ':' and value
+{
+    Tot t = DoSum(res);
+    if (Price(res[0].text, res[0].length)) t.data.price += strtod(res[2].text, 0);
+    return t;
+}
+
+/* the same by events, no data is kept per element */
+struct Extract: public Sink
+{
+    Total total;
+    bool price; // the last key is "price"
+    Extract(): price(false) {};
+    void Exit(const char* name, const char* text, size_t len, bool ok)
+    {
+        if (ok && !strcmp(name, "value")) total.values++;
+    }
+    void Match(const char* name, const char* text, size_t len)
+    {
+        if (!strcmp(name, "key")) price = Price(text, len);
+        else if (price && !strcmp(name, "number")) total.price += strtod(text, 0);
+        else price = price && *text == ':';
+    }
+};
+
+/* the same by Tree, member node has key, ':' and value children */
+struct Walk
+{
+    Total total;
+    bool operator()(const Tree& tree, int i, int)
+    {
+        const Tree::Node& n = tree[i];
+        if (!strcmp(n.name, "value")) total.values++;
+        else if (!strcmp(n.name, "member") && Price(tree.text + tree[n.child].begin, tree[n.child].end - tree[n.child].begin)) {
+            int v = tree[tree[n.child].next].next; // number lexem is child of value
+            if (tree[v].child >= 0) total.price += strtod(tree.text + tree[tree[v].child].begin, 0); }
+        return true;
+    }
+};
+
+static void Json(Rule& root)
+{
+    Token onenine('1', '9');
+    Lexem digit = "0" | onenine;
+    Lexem digits = *digit;
+    Lexem integer = digit | (onenine + digits) | ("-" + digit) | ("-" + onenine + digits);
+    LEXEM(number) = integer + !("." + digits) + !("Ee" + !Token("+-") + digits);
+    Lexem hex = digit | Token('A', 'F') | Token('a', 'f');
+    Token any(0x20, 255);
+    any.Remove("\"\\");
+    Lexem string = "\"" + *(any | ("\\" + (Token("\"\\/bfnrt") | ("u" + hex(4, 4))))) + "\"";
+    LEXEM(key) = string;
+    Rule& value = root;
+    RULE(member) = key + ":" + value;
+    RULE(object) = "{" + !(member + *("," + member)) + "}";
+    RULE(array) = "[" + !(value + *("," + value)) + "]";
+    value = object | array | string | number | Lexem("true") | Lexem("false") | Lexem("null");
+    value.setName("value");
+    Bind(value, DoValue); Bind(member, DoMember); Bind(object, DoSum); Bind(array, DoSum);
+}
+
+static std::string Record(int i)
+{
+    char buf[160];
+    sprintf(buf, "{\"id\": %d, \"name\": \"item\\n%d\", \"price\": %d.%02d, \"tags\": [\"a\", \"b\", %d],"
+        " \"stock\": {\"ok\": %s, \"left\": null}}", i, i, rand() % 1000, rand() % 100, i % 7, i % 3? "true": "false");
+    return buf;
+}
+
+int main(int argc, char* argv[])
+{
+    int num = argc > 1? atoi(argv[1]): 4000;
+    int runs = argc > 2? atoi(argv[2]): 20;
+    if (num > maxRepeate - 1) num = maxRepeate - 1;
+    std::string text = "[";
+    for (int i = 0; i < num; i++) text += (i? ",\n": "") + Record(i);
+    text += "]";
+
+    Grammar grammar(Json);
+    double best[3] = {1e9, 1e9, 1e9}; Total res[3]; int stat[3] = {0, 0, 0}; Tree tree;
+    for (int k = 0; k < runs; k++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Tot t; stat[0] = AnalyzeRange(grammar, text.c_str(), text.c_str() + text.size(), t);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        Extract e; stat[1] = AnalyzeEvents(grammar, text.c_str(), text.c_str() + text.size(), e);
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        stat[2] = AnalyzeTree(grammar, text.c_str(), text.c_str() + text.size(), tree);
+        Walk w = tree.Visit(Walk());
+        std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+        res[0] = t.data; res[1] = e.total; res[2] = w.total;
+        best[0] = std::min(best[0], std::chrono::duration<double>(t1 - t0).count());
+        best[1] = std::min(best[1], std::chrono::duration<double>(t2 - t1).count());
+        best[2] = std::min(best[2], std::chrono::duration<double>(t3 - t2).count()); }
+
+    bool same = true;
+    for (int i = 1; i < 3; i++) // order of sums differs
+        same = same && stat[0] == stat[i] && res[0].values == res[i].values && fabs(res[0].price - res[i].price) < 1e-9 * res[0].price;
+    printf("%zu bytes, %d values, price %.2f\n", text.size(), res[0].values, res[0].price);
+    printf("interface %8.2f MB/s  events %8.2f MB/s  speedup %5.2f\n", text.size() / best[0] / 1e6,
+        text.size() / best[1] / 1e6, best[0] / best[1]);
+    printf("interface %8.2f MB/s  tree   %8.2f MB/s  speedup %5.2f  %zu nodes  %s\n", text.size() / best[0] / 1e6,
+        text.size() / best[2] / 1e6, best[0] / best[2], tree.Size(), same? "same": "DIFFERENT");
+    return !same;
+}
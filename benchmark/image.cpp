@@ -0,0 +1,106 @@
+/*************************************************************************\
+*   Benchmark of grammar startup: building against loading of its image   *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build: g++ -std=c++11 -O2 -I.. image.cpp -o image                       */
+/* Usage: image [number of startups] [image file]                          */
+/* Each startup makes JSON grammar ready and parses a short document: by   */
+/* building of Rules and Program or by loading of saved image with binding */
+/* of callbacks by names; results must be the same                         */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+using namespace bnf;
+
+
+typedef Interface<int> Count;
+
+static Count DoSum(std::vector<Count>& res) // number of values inside
+{
+    int num = 0;
+    for (size_t i = 0; i < res.size(); i++) num += res[i].data;
+    return Count(num, res);
+}
+
+static Count DoValue(std::vector<Count>& res)
+{
+    return Count(1 + DoSum(res).data, res);
+}
+
+static bool DoKey(const char* lexem, size_t len)
+{
+    return len > 2; // empty keys are not allowed
+}
+
+static void Json(Rule& root)
+{
+    Token onenine('1', '9');
+    Lexem digit = "0" | onenine;
+    Lexem digits = *digit;
+    Lexem integer = digit | (onenine + digits) | ("-" + digit) | ("-" + onenine + digits);
+    Lexem number = integer + !("." + digits) + !("Ee" + !Token("+-") + digits);
+    Lexem hex = digit | Token('A', 'F') | Token('a', 'f');
+    Token any(0x20, 255);
+    any.Remove("\"\\");
+    Lexem string = "\"" + *(any | ("\\" + (Token("\"\\/bfnrt") | ("u" + hex(4, 4))))) + "\"";
+    Rule& value = root;
+    RULE(member) = string + Action(DoKey, "key") + ":" + value;
+    RULE(object) = "{" + !(member + *("," + member)) + "}";
+    RULE(array) = "[" + !(value + *("," + value)) + "]";
+    value = object | array | string | number | Lexem("true") | Lexem("false") | Lexem("null");
+    value.setName("value");
+    Bind(value, DoValue); Bind(member, DoSum); Bind(object, DoSum); Bind(array, DoSum);
+}
+
+int main(int argc, char* argv[])
+{
+    int num = argc > 1? atoi(argv[1]): 2000;
+    const char* path = argc > 2? argv[2]: "json.img";
+    const char* text = "{\"id\": 12, \"tags\": [\"a\", \"b\\n\"], \"price\": -1.5e3, \"next\": {\"ok\": true, \"no\": null}}";
+
+    Grammar grammar(Json);
+    std::string image;
+    if (!grammar.Save(image) || !grammar.Save(path)) {
+        printf("can not save %s\n", path);
+        return 1; }
+    Count c0; int s0 = Analyze(grammar, text, c0);
+
+    int errors = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < num; i++) {
+        Grammar g(Json);
+        Count c; int s = Analyze(g, text, c);
+        errors += s != s0 || c.data != c0.data; }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < num; i++) {
+        Program p(path);
+        p.Bind("value", DoValue); p.Bind("key", DoKey);
+        p.Bind("member", DoSum); p.Bind("object", DoSum); p.Bind("array", DoSum);
+        Count c; int s = Analyze(p, text, c);
+        errors += s != s0 || c.data != c0.data; }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    double build = std::chrono::duration<double>(t1 - t0).count() / num;
+    double load = std::chrono::duration<double>(t2 - t1).count() / num;
+    printf("%zu elements, image %zu bytes, %d values\n", grammar.Size(), image.size(), c0.data);
+    printf("build %8.1f us  load %8.1f us  speedup %5.2f  %s\n", build * 1e6, load * 1e6, build / load, errors? "DIFFERENT": "same");
+    remove(path);
+    return errors;
+}
@@ -0,0 +1,113 @@
+/*************************************************************************\
+*   Benchmark of regular lexems: backtracking against compiled automata   *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build: g++ -std=c++11 -O2 -I.. lexem.cpp -o lexem                       */
+/*        (add -DBNFLITE_NO_DFA to see Program without lexem automata)     */
+/* Usage: lexem [number of records]                                        */
+/* Parses space separated numbers, strings and identifiers of JSON-like    */
+/* grammar by the grammar graph and by Program, results must be the same   */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <chrono>
+
+using namespace bnf;
+
+
+static std::string Digits(int n)
+{
+    std::string s;
+    for (int i = 0; i < n; i++) s += '0' + rand() % 10;
+    return s;
+}
+
+static std::string Number()
+{
+    std::string s = rand() % 4? "": "-";
+    s += rand() % 8? std::string(1, '1' + rand() % 9) + Digits(rand() % 8): "0";
+    if (rand() % 2) s += "." + Digits(1 + rand() % 6);
+    if (rand() % 4 == 0) s += std::string("eE").substr(rand() % 2, 1) + "+-"[rand() % 2] + Digits(1 + rand() % 3);
+    return s;
+}
+
+static std::string String()
+{
+    std::string s = "\"";
+    for (int i = rand() % 32; i > 0; i--) {
+        switch (rand() % 16) {
+        case 0: s += "\\n"; break;
+        case 1: s += "\\u00e9"; break;
+        default: s += 'a' + rand() % 26; } }
+    return s + "\"";
+}
+
+static std::string Identifier()
+{
+    std::string s(1, rand() % 8? 'a' + rand() % 26: '_');
+    for (int i = rand() % 16; i > 0; i--) s += "abcdefghijklmnopqrstuvwxyz_0123456789"[rand() % 37];
+    return s;
+}
+
+static double Time(_Tie& root, const std::string& text, int& stat, const char*& stop)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    stat = AnalyzeRange(root, text.c_str(), text.c_str() + text.size(), &stop);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t num = argc > 1? atoi(argv[1]): 300000;
+
+    Token onenine('1', '9');
+    Lexem digit = "0" | onenine;
+    Lexem digits = *digit;
+    Lexem integer = digit | (onenine + digits) | ("-" + digit) | ("-" + onenine + digits);
+    Lexem fraction = !("." + digits);
+    Lexem exponent = !("Ee" + !Token("+-") + digits);
+    Lexem number = integer + fraction + exponent;
+    Lexem hex = digit | Token('A', 'F') | Token('a', 'f');
+    Lexem escape = Token("\"\\/bfnrt") | ("u" + hex(4, 4));
+    Token any(0x20, 255);
+    any.Remove("\"\\");
+    Lexem string = "\"" + *(any | ("\\" + escape)) + "\"";
+    Token letter('a', 'z');
+    letter.Add('A', 'Z'); letter.Add('_');
+    Lexem identifier = letter + *(letter | digit);
+
+    struct { const char* name; Lexem* lexem; std::string (*gen)(); } tests[] = {
+        { "number", &number, Number }, { "string", &string, String }, { "identifier", &identifier, Identifier } };
+    int errors = 0;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        std::string text;
+        for (size_t j = 0; j < num; j++) {
+            (text += tests[i].gen()) += ' '; }
+        Rule item = *tests[i].lexem;
+        Rule root = Repeat(0, item, INT_MAX);
+        Program program(root);
+        int s1, s2; const char *e1, *e2;
+        double t1 = Time(root, text, s1, e1), t2 = Time(program, text, s2, e2);
+        bool same = s1 == s2 && e1 == e2 && e2 == text.c_str() + text.size();
+        errors += !same;
+        printf("%-10s %6.1f MB  graph %7.1f MB/s  program %7.1f MB/s  speedup %5.2f  %s\n", tests[i].name,
+            text.size() / 1e6, text.size() / t1 / 1e6, text.size() / t2 / 1e6, t1 / t2, same? "same": "DIFFERENT");
+    }
+    return errors;
+}
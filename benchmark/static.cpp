@@ -0,0 +1,218 @@
+/*************************************************************************\
+*   Benchmark of grammar templates (bnf::ct) against grammar graph        *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* Build: g++ -std=c++11 -O2 -I.. static.cpp -o static                      */
+/* Usage: static [number of records]                                       */
+/* Parses calculator formulas and JSON records by the grammar graph,       */
+/* by Program and by grammar templates, results must be the same           */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <chrono>
+
+using namespace bnf;
+
+
+typedef Interface<double> Calc;
+
+static Calc DoNumber(std::vector<Calc>& res)
+{
+    return Calc(strtod(res[0].text, 0), res);
+}
+
+static Calc DoBinary(std::vector<Calc>& res)
+{
+    double value = res[0].data;
+    for (unsigned int i = 1; i < res.size(); i += 2) {
+        switch(*res[i].text) {
+            case '+': value += res[i + 1].data; break;
+            case '-': value -= res[i + 1].data; break;
+            case '*': value *= res[i + 1].data; break;
+            case '/': value /= res[i + 1].data; break;
+        }
+    }
+    return Calc(value, res);
+}
+
+static Calc DoBracket(std::vector<Calc>& res)
+{
+    return *res[0].text == '('? res[1] : res[0];
+}
+
+/* sum of formulas or number of JSON values */
+static Calc DoSum(std::vector<Calc>& res)
+{
+    double sum = 0;
+    for (unsigned int i = 0; i < res.size(); i++) sum += res[i].data;
+    return Calc(sum, res);
+}
+
+static Calc DoValue(std::vector<Calc>& res)
+{
+    double count = 1;
+    for (unsigned int i = 0; i < res.size(); i++) count += res[i].data;
+    return Calc(count, res);
+}
+
+static std::string Formula(int depth)
+{
+    char buf[16];
+    switch (rand() % (depth > 3? 2: 5)) {
+    case 0: sprintf(buf, "%d", rand() % 1000); return buf;
+    case 1: sprintf(buf, "%d.%d", 1 + rand() % 100, rand() % 10); return buf;
+    case 2: return "(" + Formula(depth + 1) + ")";
+    default: return Formula(depth + 1) + " +-*/"[1 + rand() % 4] + Formula(depth + 1);
+    }
+}
+
+static std::string Json(int depth)
+{
+    char buf[16];
+    switch (rand() % (depth > 3? 4: 6)) {
+    case 0: sprintf(buf, "%d.%de%d", rand() % 1000, rand() % 100, rand() % 10); return buf;
+    case 1: return "\"key" + std::string(rand() % 12, 'a' + rand() % 26) + "\\n\"";
+    case 2: return rand() % 2? "true": "null";
+    case 3: sprintf(buf, "%d", rand() % 100000); return buf;
+    case 4: {
+        std::string s = "[";
+        for (int i = rand() % 6; i >= 0; i--) s += Json(depth + 1) + (i? ", ": "");
+        return s + "]"; }
+    default: {
+        std::string s = "{";
+        for (int i = rand() % 6; i >= 0; i--) {
+            sprintf(buf, "\"f%d\": ", i); s += buf + Json(depth + 1) + (i? ",\n": ""); }
+        return s + "}"; }
+    }
+}
+
+static double Time(_Tie& root, const std::string& text, int& stat, Calc& res)
+{
+    double best = 1e9;
+    for (int i = 0; i < 3; i++) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        stat = AnalyzeRange(root, text.c_str(), text.c_str() + text.size(), res);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (sec < best) best = sec; }
+    return best;
+}
+
+static int Compare(const char* name, _Tie& graph, _Tie& tmpl, const std::string& text)
+{
+    Program program(graph);
+    _Tie* roots[] = { &graph, &program, &tmpl };
+    int stat[3]; Calc res[3]; double sec[3];
+    for (int i = 0; i < 3; i++) {
+        sec[i] = Time(*roots[i], text, stat[i], res[i]); }
+    bool same = true;
+    for (int i = 1; i < 3; i++) {
+        same = same && stat[i] == stat[0] && !memcmp(&res[i].data, &res[0].data, sizeof(double)) && res[i].length == res[0].length; }
+    same = same && !(stat[0] & eError);
+    printf("%-5s %6.1f MB  graph %6.1f MB/s  program %6.1f MB/s  templates %6.1f MB/s  speedup %5.2f  %s\n", name,
+        text.size() / 1e6, text.size() / sec[0] / 1e6, text.size() / sec[1] / 1e6, text.size() / sec[2] / 1e6,
+        sec[0] / sec[2], same? "same": "DIFFERENT");
+    return !same;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t num = argc > 1? atoi(argv[1]): 100000;
+    int errors = 0;
+
+    {   /* calculator by grammar graph */
+        Token digit("0123456789");
+        Lexem number_ = 1*digit + !("." + 1*digit);
+        Rule number = number_;
+        Rule expression;
+        Rule primary = ("(" + expression + ")") | number;
+        Rule mul = primary + *("*/" + primary);
+        expression = mul + *("+-" + mul);
+        Bind(number, DoNumber);
+        Bind(primary, DoBracket);
+        Bind(mul, DoBinary);
+        Bind(expression, DoBinary);
+        Rule root = Repeat(0, expression, INT_MAX);
+        Bind(root, DoSum);
+
+        /* the same by grammar templates */
+        ct::Token c_digit("0123456789");
+        auto c_number = ct::Rule(ct::Lexem(1*c_digit + !("." + 1*c_digit)))[DoNumber];
+        ct::Forward c_expression;
+        auto c_primary = ct::Rule(("(" + c_expression + ")") | c_number)[DoBracket];
+        auto c_mul = ct::Rule(c_primary + *("*/" + c_primary))[DoBinary];
+        auto c_sum = ct::Rule(c_mul + *("+-" + c_mul))[DoBinary];
+        c_expression = c_sum;
+        auto c_all = ct::Rule(ct::Repeat(0, c_expression, INT_MAX))[DoSum];
+        auto c_root = ct::Root(c_all);
+
+        std::string text;
+        for (size_t i = 0; i < num; i++) {
+            (text += Formula(0)) += "\n"; }
+        errors += Compare("calc", root, c_root, text);
+        expression = Null();  // disjoin Rule recursion to safe Rules removal
+    }
+    {   /* JSON by grammar graph */
+        Token onenine('1', '9');
+        Lexem digit = "0" | onenine;
+        Lexem digits = *digit;
+        Lexem integer = digit | (onenine + digits) | ("-" + digit) | ("-" + onenine + digits);
+        Lexem number = integer + !("." + digits) + !("Ee" + !Token("+-") + digits);
+        Lexem hex = digit | Token('A', 'F') | Token('a', 'f');
+        Lexem escape = Token("\"\\/bfnrt") | ("u" + hex(4, 4));
+        Token any(0x20, 255);
+        any.Remove("\"\\");
+        Lexem string = "\"" + *(any | ("\\" + escape)) + "\"";
+        Rule value;
+        Rule array = "[" + !(value + *("," + value)) + "]";
+        Rule member = string + ":" + value;
+        Rule object = "{" + !(member + *("," + member)) + "}";
+        value = object | array | string | number | Lexem("true") | Lexem("false") | Lexem("null");
+        Bind(array, DoValue);
+        Bind(member, DoSum);
+        Bind(object, DoValue);
+        Rule root = Repeat(0, value, INT_MAX);
+        Bind(root, DoSum);
+
+        /* the same by grammar templates */
+        ct::Token c_onenine('1', '9');
+        auto c_digit = ct::Lexem("0" | c_onenine);
+        auto c_digits = ct::Lexem(*c_digit);
+        auto c_integer = ct::Lexem(c_digit | (c_onenine + c_digits) | ("-" + c_digit) | ("-" + c_onenine + c_digits));
+        auto c_number = ct::Lexem(c_integer + !("." + c_digits) + !("Ee" + !ct::Token("+-") + c_digits));
+        auto c_hex = ct::Lexem(c_digit | ct::Token('A', 'F') | ct::Token('a', 'f'));
+        auto c_escape = ct::Lexem(ct::Token("\"\\/bfnrt") | ("u" + c_hex(4, 4)));
+        auto c_string = ct::Lexem("\"" + *(ct::Token(any) | ("\\" + c_escape)) + "\"");
+        ct::Forward c_value;
+        auto c_array = ct::Rule("[" + !(c_value + *("," + c_value)) + "]")[DoValue];
+        auto c_member = ct::Rule(c_string + ":" + c_value)[DoSum];
+        auto c_object = ct::Rule("{" + !(c_member + *("," + c_member)) + "}")[DoValue];
+        auto c_value_ = ct::Rule(c_object | c_array | c_string | c_number
+            | ct::Lexem("true") | ct::Lexem("false") | ct::Lexem("null"));
+        c_value = c_value_;
+        auto c_all = ct::Rule(ct::Repeat(0, c_value, INT_MAX))[DoSum];
+        auto c_root = ct::Root(c_all);
+
+        std::string text;
+        for (size_t i = 0; i < num; i++) {
+            (text += Json(0)) += "\n"; }
+        errors += Compare("json", root, c_root, text);
+        value = Null();
+    }
+    return errors;
+}
@@ -32,8 +32,54 @@
 #include <vector>
 #include <bitset>
 #include <map>
+#include <set>
 #include <algorithm>
 #include <typeinfo>
+#include <stdio.h>
+#if defined(__unix__) || defined(__APPLE__)
+#define BNFLITE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if __cplusplus > 199711L
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <utility>
+#include <type_traits>
+#include <tuple>
+#define BNFLITE_MOVE(x) std::move(x)
+#else
+#define BNFLITE_MOVE(x) (x)
+#endif
+#if __cplusplus > 199711L
+#include <chrono>
+#else
+#include <time.h>
+#endif
+#if defined(BNFLITE_PROFILE)
+#include <ostream>
+#endif
+#if defined(BNFLITE_NO_SIMD)
+#elif defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__) // aligned loads can read after end of text
+#define BNFLITE_NO_SIMD
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define BNFLITE_NO_SIMD
+#endif
+#endif
+#if !defined(BNFLITE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define BNFLITE_SIMD
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
 namespace bnf
 {
@@ -56,58 +102,348 @@ namespace bnf
 //      * Rule (or RULE) is used here as synonym of syntax production
 // To parse any number (e.g. 532) it is just enough to call the bnf::Analyze(Number, "532")
 
-enum Limits {   maxCharNum = 256, maxLexemLength = 1024, maxRepeate = 4096, maxEmptyStack = 16
+enum Limits {   maxCharNum = 256, maxLexemLength = 1024, maxRepeate = 4096, maxEmptyStack = 16,
+                maxMemoSize = 0x10000
             };
-enum Status {   eNone = 0, eOk = 1,
+enum Status {   eNone = 0, eOk = 1, eCut = 0x4,
                 eRet = 0x8, e1st = 0x10, eSkip = 0x20, eTry = 0x40, eNull = 0x80,
                 eRest = 0x0100, eNoData = 0x0200, eOver = 0x0400, eEof = 0x0800,
-                eBadRule = 0x1000, eBadLexem = 0x2000, eSyntax = 0x4000,
+                eBadRule = 0x1000, eBadLexem = 0x2000, eSyntax = 0x4000, eBudget = 0x8000,
                 eError = ((~(unsigned int)0) >> 1) + 1
             };
 
-class _Tie; class _And; class _Or; class _Cycle;
+class _Tie; class _And; class _Or; class _Cycle; struct _Op; struct _Span; struct _Nfa; class Program; class _Inspector;
+struct _Static; struct _Image;
+inline unsigned int _symbol(const char*& cc, const char* end);
+
+#if defined(BNFLITE_SIMD)
+inline unsigned int _ctz(unsigned int bits) // index of lowest set bit
+#if defined(_MSC_VER)
+    {   unsigned long i; _BitScanForward(&i, bits); return i; }
+#else
+    {   return __builtin_ctz(bits); }
+#endif
+#endif
+
+/* declarative comments to be skipped by pre-parser between tokens of rules */
+struct Comments
+{
+    const char* line;   // start of line comment (e.g. "//"), it ends by new line
+    const char* open;   // start of block comment (e.g. "/*")
+    const char* close;  // end of block comment (e.g. "*/")
+    Comments(const char* line = 0, const char* open = 0, const char* close = 0)
+        :line(line), open(open), close(close)
+        {};
+};
+
+/* syntax error skipped by Rule with Recover(), parsing goes on from 'next' */
+struct Fault
+{
+    const char* start;  // beginning of the failed rule
+    const char* stop;   // the furthest point reached by its subrules, where the error is
+    const char* next;   // end of skipped text, just after synchronization character
+    std::string rule;   // name of the failed rule
+};
+
+/* optional settings of Analyze call */
+struct Options
+{
+    size_t memo;    // capacity of memo table to memoize all Rules and Lexems (0 - Memoize() marked only)
+    size_t pruned;  // output: number of alternatives skipped by FIRST sets of Program
+    Comments comments;  // comments to be skipped after pre-parser
+    void* user;     // context of the call passed to callbacks of the first kind with three arguments
+    std::vector<Fault> faults;  // output: syntax errors skipped by Rules with Recover()
+    size_t steps;   // budget of parse steps, i.e. calls of rules, lexems, disjunctions and repetitions (0 - no limit)
+    size_t depth;   // budget of context stack entries, a pointer each (0 - no limit)
+    double timeout; // budget of wall-clock time in seconds, checked every 256 steps (0 - no limit)
+    size_t spent;   // output: number of parse steps, the call stops with eBudget|eError if a budget is over
+    const char* (*pre_parse)(const char* ptr, const char* end); // pre-parser bounded by end of text, used instead of argument
+    Options(): memo(0), pruned(0), user(0), steps(0), depth(0), timeout(0), spent(0), pre_parse(0)
+        {};
+};
+
+#if defined(BNFLITE_PROFILE)
+/* counters of rule or lexem collected in BNFLITE_PROFILE build */
+struct _Prof
+{
+    size_t calls, ok, fail, again, bytes;   // 'again' - calls at position already visited by the same element
+    double incl, excl;                      // time (seconds) with and without nested rules and lexems
+    _Prof(): calls(0), ok(0), fail(0), again(0), bytes(0), incl(0), excl(0)
+        {};
+    _Prof& operator+=(const _Prof& p)
+        {   calls += p.calls; ok += p.ok; fail += p.fail; again += p.again; bytes += p.bytes;
+            incl += p.incl; excl += p.excl; return *this; }
+};
+inline std::map<std::string, _Prof>& _profile() // totals of all Analyze calls by names of elements
+    {   static std::map<std::string, _Prof> prof; return prof; }
+#if __cplusplus > 199711L
+inline std::mutex& _profile_lock()
+    {   static std::mutex lock; return lock; }
+#endif
+#endif
+#if __cplusplus > 199711L
+inline double _now()
+    {   return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+#else
+inline double _now() // processor time is the best clock of C++98
+    {   return (double)clock() / CLOCKS_PER_SEC; }
+#endif
 
 /* context class to support the first kind of callback */
 class _Base // base parser class
 {
 public:
     std::vector<const char*> cntxV; // public for internal extensions
+    size_t pruned;                  // statistics of skipped alternatives
+    void* user;                     // context of Analyze call for callbacks of the first kind
+    std::vector<Fault> faults;      // syntax errors skipped by Rules with Recover()
+    size_t steps;                   // parse steps of the call
 protected:  friend class Token; friend class Lexem; friend class Rule;
             friend class _And;  friend class _Or;   friend class _Cycle;
+            friend class Action; friend struct _Op; template <class> friend class Session;
+            friend struct _Static;
     int level;
     const char* pstop;
+    const char* pend;   // end of text, it need not be terminated by NUL
+    bool tail;  // end of text is examined, so result can depend on next data (see Session)
+    int _end(int stat)
+        {   tail = true; return stat; }
+    struct _Memo { const void* key; const char* org; const char* lo; const char* hi; int stat; int val;
+                   const char* far; const char* p1; const char* pn; size_t k1, kn, n; }; // furthest point, exits of cycles
+    struct _Mark { size_t calls, runs; const char* org; }; // exits of cycles before remembered element
+    std::vector<_Memo> memo; // packrat table: (rule, position) -> status, result and user data
+    size_t memo_num, memo_cap;
+    bool memo_all;
+    _Memo* _memo_slot(const void* key, const char* org)
+        {   size_t msk = memo.size() - 1, i = ((size_t)key >> 4 ^ (size_t)org * 0x9E3779B1u) & msk;
+            while (memo[i].key && (memo[i].key != key || memo[i].org != org)) {
+                i = (i + 1) & msk; }
+            return &memo[i]; }
+    bool _memo_get(const void* key, int& stat, _Mark& mark)
+        {   mark.calls = stk_calls; mark.runs = stk_runs.size(); mark.org = stk_org; stk_log = true;
+            if (!memo.size()) return false;
+            _Memo* m = _memo_slot(key, cntxV.back());
+            if (!m->key || !_chk_replay(*m, false) || (m->lo && !_memo_val(m->val, false))) return false;
+            _chk_replay(*m, true);
+            if (m->lo) {
+                cntxV.push_back(m->lo); cntxV.push_back(m->hi); }
+            if (m->far > pstop) pstop = m->far;
+            stat = m->stat;
+            return true; }
+    void _memo_put(const void* key, size_t size, int stat, const _Mark& mark)
+        {   if (memo_num >= memo_cap) return;
+            if (2 * (memo_num + 1) > memo.size()) {
+                std::vector<_Memo> old(memo.size()? 2 * memo.size() : 64); old.swap(memo);
+                for (size_t i = 0; i < old.size(); i++) {
+                    if (old[i].key) *_memo_slot(old[i].key, old[i].org) = old[i]; } }
+            _Memo* m = _memo_slot(key, cntxV[size - 1]);
+            if (!m->key) memo_num++;
+            m->key = key; m->org = cntxV[size - 1]; m->stat = stat; m->val = -1;
+            m->lo = cntxV.size() > size? cntxV[size] : 0; m->hi = cntxV.back(); m->far = pstop;
+            _chk_save(*m, mark);
+            if (m->lo) _memo_val(m->val, true); }
+    virtual bool _memo_val(int& val, bool save)
+        {   return true; }
+#if defined(BNFLITE_PROFILE)
+    friend class _Probe;
+    std::map<const std::string*, _Prof> prof;  // counters of this call by names of elements
+    std::set<std::pair<const std::string*, const char*> > seen; // visited positions
+    std::vector<double> nested; // time of nested elements of active calls
+    void _profile_flush()
+        {
+#if __cplusplus > 199711L
+            std::lock_guard<std::mutex> lock(_profile_lock());
+#endif
+            for (std::map<const std::string*, _Prof>::iterator itr = prof.begin(); itr != prof.end(); ++itr) {
+                _profile()[*itr->first] += itr->second; }
+            prof.clear(); seen.clear(); nested.clear(); }
+#endif
+    size_t step_chk, step_max, depth_max; // next step to check budgets, budgets of steps and stack
+    double timeout, deadline;
+    int over;   // eBudget|eError after any budget is over
+    int _step() // budgets are checked by calls of rules, lexems, disjunctions and repetitions
+        {   return ++steps < step_chk && cntxV.size() <= depth_max? 0 : _budget(); }
+    int _budget()
+        {   if (!over && (steps >= step_max || cntxV.size() > depth_max || (deadline && _now() > deadline)))
+                over = eBudget|eError;
+            step_chk = over? 0 : deadline? std::min(steps + 256, step_max) : step_max; // clock is read by samples
+            return over; }
+    const char* stk_org; int stk_cnt; // position of repeated empty cycles
+    struct _Run { const char* org; size_t call; }; // cycle exits from call number at the same position
+    std::vector<_Run> stk_runs; // logged for memo, so remembered elements repeat exits of cycles
+    size_t stk_calls;
+    bool stk_log;
     int _chk_stack()
-        {   static const char* org; static int cnt;
-            if (org != cntxV.back()) { org = cntxV.back(); cnt = 0; }
-            else if (++cnt > maxEmptyStack) return  eOver|eError;
+        {   stk_calls++;
+            if (stk_org != cntxV.back()) {
+                stk_org = cntxV.back(); stk_cnt = 0;
+                if (stk_log) { _Run r = { stk_org, stk_calls }; stk_runs.push_back(r); } }
+            else if (++stk_cnt > maxEmptyStack) return  eOver|eError;
             return 0; }
+    void _chk_save(_Memo& m, const _Mark& mark) // first and last runs of exits, inner ones do not depend on others
+        {   m.n = stk_calls - mark.calls; m.k1 = m.kn = 0;
+            if (!m.n) return;
+            size_t i = mark.runs, runs = stk_runs.size() - i;
+            if (runs && stk_runs[i].call == mark.calls + 1) { // the first exit moves
+                m.p1 = stk_runs[i].org; m.k1 = (runs > 1? stk_runs[i + 1].call : stk_calls + 1) - stk_runs[i].call; runs--; i++; }
+            else { m.p1 = mark.org; m.k1 = (runs? stk_runs[i].call : stk_calls + 1) - mark.calls - 1; }
+            if (runs) { m.pn = stk_runs.back().org; m.kn = stk_calls + 1 - stk_runs.back().call; } }
+    bool _chk_replay(const _Memo& m, bool apply) // repeat exits of remembered element, false if check fails
+        {   if (!m.n) return true;
+            int cnt = stk_org == m.p1? stk_cnt + (int)m.k1 : (int)m.k1 - 1;
+            if (cnt > maxEmptyStack || (int)m.kn - 1 > maxEmptyStack) return false; // the element is parsed again
+            if (!apply) return true;
+            if (stk_org != m.p1) { _Run r = { m.p1, stk_calls + 1 }; stk_runs.push_back(r); }
+            stk_org = m.p1; stk_cnt = cnt; stk_calls += m.k1;
+            if (m.kn) {
+                if (m.n > m.k1 + m.kn) { _Run r = { 0, stk_calls + 1 }; stk_runs.push_back(r); } // inner runs
+                _Run r = { m.pn, stk_calls + 1 + m.n - m.k1 - m.kn }; stk_runs.push_back(r);
+                stk_org = m.pn; stk_cnt = (int)m.kn - 1; stk_calls += m.n - m.k1; }
+            return true; }
     const char* (*zero_parse)(const char*);
+    const char* (*zero_parse_end)(const char*, const char*);
+    Comments comments;
+    struct _Skip { const char* org; const char* ptr; } skips[16]; // last results of pre-parser
+    const char* _skip(const char* ptr) // pre-parser call by memoized results
+        {   _Skip& s = skips[((size_t)ptr ^ (size_t)ptr >> 4) & 15];
+            if (s.org != ptr) {
+                s.org = ptr; s.ptr = comments.line || comments.open? _comment(ptr) : _pre(ptr); }
+            if (s.ptr == pend) tail = true;
+            return s.ptr; }
+    const char* _pre(const char* ptr) // pre-parser bounded by end of text
+        {   if (ptr >= pend) return pend;
+            ptr = zero_parse_end? zero_parse_end(ptr, pend) : zero_parse == base_parser? _blanks(ptr, pend) : zero_parse(ptr);
+            return ptr < pend? ptr : pend; }
+    bool _starts(const char* ptr, const char* str)
+        {   size_t len = strlen(str); return (size_t)(pend - ptr) >= len && !memcmp(ptr, str, len); }
+    const char* _comment(const char* ptr)
+        {   for (const char* org = 0; org != ptr; ) {
+                org = ptr = _pre(ptr);
+                if (comments.line && _starts(ptr, comments.line)) {
+                    ptr = (const char*)memchr(ptr, '\n', pend - ptr);
+                    ptr = ptr? ptr + 1 : pend; }
+                else if (comments.open && _starts(ptr, comments.open)) {
+                    const char* end = std::search(ptr + strlen(comments.open), pend,
+                        comments.close, comments.close + strlen(comments.close));
+                    if (end != pend) ptr = end + strlen(comments.close); } }
+            return ptr; }
     int catch_error(const char* ptr) // attempt to catch general syntax error
         { return eSyntax|eError; }
+    template <class S> int _recover(const S& sync, size_t size, const char* stop, const std::string& name, int stat)
+        {   const char* org = _skip(cntxV[size - 1]); // panic mode: skip failed rule up to synchronization character
+            if (org == pend)
+                return stat;
+            const char* cc = stop > org? stop : org;
+            while (cc != pend && !sync.test(_symbol(cc, pend))) {}
+            if (cc == pend) tail = true; // next data can complete the rule
+            while (faults.size() && faults.back().start >= org) { // errors inside skipped text
+                faults.pop_back(); }
+            Fault f = { org, stop > org? stop : org, cc, name };
+            faults.push_back(f);
+            cntxV.push_back(org); cntxV.push_back(cc);
+            _stub_call(size, name.c_str());
+            return eOk|eSyntax; }
     virtual void _erase(int low, int up = 0)
         {   cntxV.erase(cntxV.begin() + low,  up? cntxV.begin() + up : cntxV.end() ); }
-    virtual std::pair<void*, int> _pre_call(void* callback)
+    virtual std::pair<void*, int> _pre_call(void* callback, const char* name)
         {   return std::make_pair((void*)0, 0); }
-    virtual void _post_call(std::pair<void*, int> up)
+    virtual void _post_call(std::pair<void*, int> up, int stat)
         {};
     virtual void _do_call(std::pair<void*, int> up, void* callback, size_t org, const char* name)
         {};
     virtual void _stub_call(size_t org, const char* name)
         {};
 public:
-    int _analyze(_Tie& root, const char* text, size_t*);
-    _Base(const char* (*pre)(const char*)) : level(1), pstop(0), zero_parse(pre?pre:base_parser)
-        {};
+    int _analyze(_Tie& root, const char* text, const char* end, size_t*, bool part = false);
+    _Base(const char* (*pre)(const char*), Options* opt = 0) : pruned(0), user(opt? opt->user : 0), steps(0),
+        level(1), pstop(0), pend(0), tail(false),
+        memo_num(0), memo_cap(opt && opt->memo? opt->memo : (size_t)maxMemoSize), memo_all(opt && opt->memo),
+        step_chk(0), step_max(opt && opt->steps? opt->steps : ~(size_t)0),
+        depth_max(opt && opt->depth? opt->depth : ~(size_t)0), timeout(opt? opt->timeout : 0), deadline(0), over(0),
+        stk_org(0), stk_cnt(0), stk_calls(0), stk_log(false), zero_parse(pre?pre:base_parser),
+        zero_parse_end(opt? opt->pre_parse : 0), comments(opt? opt->comments : Comments())
+        {   memset(skips, 0, sizeof(skips)); };
     virtual ~_Base()
         {};
+    virtual void _reset() // prepare context to parse next text
+        {   cntxV.clear(); level = 1; pstop = 0; pend = 0; tail = false; stk_org = 0; stk_cnt = 0;
+            stk_runs.clear(); stk_calls = 0; stk_log = false;
+            faults.clear(); steps = 0; memo.clear(); memo_num = 0; memset(skips, 0, sizeof(skips)); }
     // default pre-parser procedure to skip special symbols
     static const char* base_parser(const char* ptr)
-        {   for (char cc = *ptr; cc != 0; cc = *++ptr) {
-                if (cc != ' ' && cc !='\t' && cc != '\n' && cc != '\r') {
+        {   return _blanks(ptr, 0); }
+    static const char* _blanks(const char* ptr, const char* end) // skip up to end (0 - up to NUL)
+        {
+#if defined(BNFLITE_SIMD)
+            if (ptr != end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r')) {
+                const char* a = (const char*)((size_t)ptr & ~(size_t)15);
+                for (unsigned int skip = ptr - a; !end || a < end; a += 16, skip = 0) { // aligned loads stay in page
+                    __m128i x = _mm_load_si128((const __m128i*)a);
+                    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                        _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))), _mm_or_si128(_mm_cmpeq_epi8(x,
+                        _mm_set1_epi8('\n')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+                    unsigned int miss = ~_mm_movemask_epi8(m) & (0xFFFFu << skip) & 0xFFFFu;
+                    if (miss) {
+                        ptr = a + _ctz(miss); break; }
+                    ptr = a + 16; }
+                return end && ptr > end? end : ptr; }
+            return ptr;
+#else
+            for (; ptr != end; ptr++) {
+                if (*ptr != ' ' && *ptr !='\t' && *ptr != '\n' && *ptr != '\r') {
                     break; } }
-            return ptr; }
+            return ptr;
+#endif
+        }
 };
 
+#if defined(BNFLITE_PROFILE)
+/* counts and times one call of rule or lexem, 'stat' is read at the exit */
+class _Probe
+{
+    _Base* parser; const std::string* key; const int& stat; const char* org; double start;
+public:
+    _Probe(_Base* parser, const std::string& name, const int& stat)
+        :parser(parser), key(&name), stat(stat), org(parser->cntxV.back()), start(_now())
+        {   parser->nested.push_back(0); }
+    ~_Probe()
+        {   double time = _now() - start, sub = parser->nested.back();
+            parser->nested.pop_back();
+            if (parser->nested.size()) parser->nested.back() += time;
+            _Prof& p = parser->prof[key];
+            p.calls++; p.incl += time; p.excl += time - sub;
+            if (!parser->seen.insert(std::make_pair(key, org)).second) p.again++;
+            if (stat & eOk) { p.ok++; p.bytes += parser->cntxV.back() - org; }
+            else p.fail++; }
+};
+
+/* Report of rules and lexems sorted by own time (without nested elements) of all Analyze calls */
+inline void DumpProfile(std::ostream& out)
+{   std::vector<std::pair<double, const std::string*> > order; char line[256];
+#if __cplusplus > 199711L
+    std::lock_guard<std::mutex> lock(_profile_lock());
+#endif
+    for (std::map<std::string, _Prof>::iterator itr = _profile().begin(); itr != _profile().end(); ++itr) {
+        order.push_back(std::make_pair(-itr->second.excl, &itr->first)); }
+    std::sort(order.begin(), order.end());
+    snprintf(line, sizeof(line), "%-24s %10s %10s %10s %10s %12s %10s %10s\n",
+        "name", "calls", "ok", "fail", "again", "bytes", "incl ms", "excl ms");
+    out << line;
+    for (size_t i = 0; i < order.size(); i++) {
+        const _Prof& p = _profile()[*order[i].second];
+        snprintf(line, sizeof(line), "%-24.24s %10lu %10lu %10lu %10lu %12lu %10.3f %10.3f\n",
+            order[i].second->c_str(), (unsigned long)p.calls, (unsigned long)p.ok, (unsigned long)p.fail,
+            (unsigned long)p.again, (unsigned long)p.bytes, p.incl * 1000, p.excl * 1000);
+        out << line; } }
+
+inline void ResetProfile()
+{
+#if __cplusplus > 199711L
+    std::lock_guard<std::mutex> lock(_profile_lock());
+#endif
+    _profile().clear(); }
+#endif
+
 #if !defined(_MSC_VER)
 #define _NAME_OFF 0
 #else
@@ -117,21 +453,40 @@ public:
 /* internal base class to support multiform relationships between different BNFlite elements */
 class _Tie
 {
-    bool _is_compound();
+    bool _is_compound() const
+        {   return kind == kAnd || kind == kOr; }
 protected:              friend class _Base; friend class ExtParser;
     friend class _And;  friend class _Or;   friend class _Cycle;
     friend class Token; friend class Lexem; friend class Rule;
+    friend struct _Op;  friend struct _Nfa; friend class Program; friend class _Inspector;
+    friend struct _Static; friend class _Graph;
+    enum Kind { kTie, kCtrl, kToken, kAction, kAnd, kOr, kCycle, kLexem, kRule, kChar };
 
     bool inner;
     mutable std::vector<const _Tie*> use;
+    mutable std::vector<std::list<const _Tie*>::iterator> place; // positions of this in use[i]->usage
     mutable std::list<const _Tie*> usage;
-    std::string name;
+    std::string name;   // compound elements are named on demand by _name()
+    int kind;   // precomputed type of the element instead of dynamic_cast
     template<class T> static void _setname(T* t, const char * name = 0)
-        {   static int cnt = 0;
-            if (name) { t->name = name; }
-            else { t->name = typeid(*t).name() + _NAME_OFF;
-                   for (int i = ++cnt; i != 0; i /= 10) {
-                       t->name += '0' + i - (i/10)*10; } } }
+        {
+#if __cplusplus > 199711L
+            static std::atomic<int> cnt(0); // grammars can be built in parallel
+#else
+            static int cnt = 0;
+#endif
+            if (name) { t->name = name; return; }
+            char buf[16]; char* p = buf + sizeof(buf);
+            for (int i = ++cnt; i != 0; i /= 10) {
+                *--p = '0' + i % 10; }
+            (t->name = typeid(*t).name() + _NAME_OFF).append(p, buf + sizeof(buf) - p); }
+    std::string _name() const
+        {   if (!_is_compound())
+                return name.size() || kind != kAction? name: std::string("()");
+            std::string s;
+            for (size_t i = 0; i < use.size(); i++) {
+                (s += i? (kind == kAnd? "+": "|"): "") += use[i]? use[i]->_name(): ""; }
+            return s; }
     void _clone(const _Tie* lnk)
         {   usage.swap(lnk->usage);
             for (std::list<const _Tie*>::const_iterator usg = usage.begin(); usg != usage.end(); ++usg) {
@@ -139,43 +494,55 @@ protected:              friend class _Base; friend class ExtParser;
                    if ((*usg)->use[i] == lnk) {
                         (*usg)->use[i] = this; } } }
             use.swap(lnk->use);
-            for (size_t i = 0; i < use.size(); i++) {
-                if (!use[i]) continue;
-                std::list<const _Tie*>::iterator itr =
-                    std::find(use[i]->usage.begin(), use[i]->usage.end(), lnk);
-                *itr = this; }
+            place.swap(lnk->place);
+            for (size_t i = 0; i < place.size(); i++) {
+                if (use[i]) *place[i] = this; }
             if(lnk->inner) {
                 delete lnk; } }
-    _Tie(std::string nm = "") :inner(false), name(nm)
+    _Tie(std::string nm = "", int knd = kTie) :inner(false), name(nm), kind(knd)
         {};
-    explicit _Tie(const _Tie* lnk) : inner(true), name(lnk->name)
+    explicit _Tie(const _Tie* lnk) : inner(true), name(lnk->name), kind(lnk->kind)
         {   _clone(lnk); }
-    _Tie(const _Tie& link) : inner(link.inner), name(link.name)
+    _Tie(const _Tie& link) : inner(link.inner), name(link.name), kind(link.kind)
         {   _clone(&link); }
     virtual ~_Tie()
         {   for (size_t i = 0; i < use.size(); i++) {
                 const _Tie* lnk = use[i];
                 if (lnk) {
-                    lnk->usage.remove(this);
-                    for (size_t j = 0; j < use.size(); j++) {
-                        if ( use[j] == lnk) {
-                            use[j] = 0; } }
-                    if (lnk->inner && lnk->usage.size() == 0) {
+                    lnk->usage.erase(place[i]);
+                    if (lnk->inner && lnk->usage.empty()) {
                         delete lnk; } } } }
     static int call_1st(const _Tie* lnk, _Base* parser)
         {   return lnk->_parse(parser); }
+    int _predict(_Base*) const // no FIRST sets for grammar graph
+        {   return 0; }
+    bool _first(_Base*, int) const
+        {   return true; }
     void _clue(const _Tie& link)
-        {   if (!use.size() || _is_compound()) {
+        {   std::list<const _Tie*>::iterator at = link.usage.insert(link.usage.end(), this);
+            if (!use.size() || _is_compound()) {
                 use.push_back(&link);
+                place.push_back(at);
             } else {
                 if (use[0]) {
-                    use[0]->usage.remove(this);
-                    if (use[0]->inner && use[0]->usage.size() == 0) {
+                    use[0]->usage.erase(place[0]);
+                    if (use[0]->inner && use[0]->usage.empty()) {
                         delete use[0]; } }
-                use[0] = &link; }
-            link.usage.push_back(this); }
+                use[0] = &link;
+                place[0] = at; } }
+    static void _release(const _Tie* root) // disjoin all links of graph to delete its inner elements
+        {   std::vector<const _Tie*> all(1, root); std::set<const _Tie*> seen(all.begin(), all.end());
+            for (size_t k = 0; k < all.size(); k++) {
+                for (size_t i = 0; i < all[k]->use.size(); i++) {
+                    if (all[k]->use[i] && seen.insert(all[k]->use[i]).second) all.push_back(all[k]->use[i]); } }
+            for (size_t k = 0; k < all.size(); k++) {
+                for (size_t i = 0; i < all[k]->use.size(); i++) {
+                    if (all[k]->use[i]) all[k]->use[i]->usage.erase(all[k]->place[i]); }
+                all[k]->use.clear(); all[k]->place.clear(); }
+            for (size_t k = 0; k < all.size(); k++) {
+                if (all[k]->inner && all[k]->usage.empty()) delete all[k]; } }
     template<class T> static T* _safe_delete(T* t)
-        {   if (t->usage.size() != 0)  {
+        {   if (!t->usage.empty())  {
                 if (!t->inner)    {
                     return new T(t); } }
             return 0; }
@@ -184,17 +551,22 @@ public:
     void setName(const char * name)
         {   this->name = name; }
     const char *getName()
-        {   return name.c_str(); }
+        {   if (_is_compound()) name = _name();
+            return name.c_str(); }
     _And operator+(const _Tie& link);
     _And operator+(const char* s);
     _And operator+(bool (*f)(const char*, size_t));
+    _And operator+(bool (*f)(const char*, size_t, void*));
     friend _And operator+(const char* s, const _Tie& lnk);
     friend _And operator+(bool (*f)(const char*, size_t),const _Tie& lnk);
+    friend _And operator+(bool (*f)(const char*, size_t, void*),const _Tie& lnk);
     _Or operator|(const _Tie& link);
     _Or operator|(const char* s);
     _Or operator|(bool (*f)(const char*, size_t));
+    _Or operator|(bool (*f)(const char*, size_t, void*));
     friend _Or operator|(const char* s, const _Tie& lnk);
     friend _Or operator|(bool (*f)(const char*, size_t), const _Tie& lnk);
+    friend _Or operator|(bool (*f)(const char*, size_t, void*), const _Tie& lnk);
 
     // Support Augmented BNF constructions like "<a>*<b><element>" to implement repetition;
     // In ABNF <a> and <b> imply at least <a> and at most <b> occurrences of the element;
@@ -216,7 +588,7 @@ protected:  friend class _Tie;
     _Ctrl(const _Ctrl& control) :_Tie(control)
         {};
 public:
-     explicit _Ctrl(): _Tie(std::string(1, cc))
+     explicit _Ctrl(): _Tie(std::string(1, cc), kCtrl)
         {};
     ~_Ctrl()
         {   _safe_delete(this); }
@@ -234,6 +606,9 @@ typedef _Ctrl<e1st, '1'> AcceptFirst;
 /* Try to catch syntax error in current conjunction rule */
 typedef _Ctrl<eOk|eTry, 'T'> Try;
 
+/* Commit the choice like Try(), the nearest repetition of rules releases results of its iterations before the cut */
+typedef _Ctrl<eOk|eTry|eCut, 'C'> Cut;
+
 /* Check but do not accept next statement for conjunction rule */
 typedef _Ctrl<eOk|eSkip, 'S'> Skip;
 
@@ -241,70 +616,123 @@ typedef _Ctrl<eOk|eSkip, 'S'> Skip;
 typedef _Ctrl<eError|eSyntax, 'E'> Catch;
 
 
+/* next character of text: byte, or UTF-8 code point for BNFLITE_WIDE (invalid byte is taken as is) */
+inline unsigned int _symbol(const char*& cc, const char* end)
+    {   unsigned int c = *(const unsigned char*)cc++;
+#if defined(BNFLITE_WIDE)
+        int n = c < 0xC0? 0 : c < 0xE0? 1 : c < 0xF0? 2 : c < 0xF8? 3 : 0;
+        if (!n || end - cc < n) return c;
+        unsigned int u = c & (0x3F >> n);
+        for (int i = 0; i < n; i++) {
+            if ((((const unsigned char*)cc)[i] & 0xC0) != 0x80) return c;
+            u = u << 6 | (((const unsigned char*)cc)[i] & 0x3F); }
+        cc += n;
+        return u;
+#else
+        return c;
+#endif
+    }
+
 /* interface class for tokens */
 class Token: public _Tie
 {
     Token& operator=(const _Tie&);
     explicit Token(const _Tie&);
 public:
-    class interval_set : protected std::map<wchar_t,bool>
+    class interval_set // set of code points: bitmap of ASCII and sorted ranges of the others
     {
+        typedef std::pair<unsigned int, unsigned int> _Range; // first and last code point
+        unsigned int ascii[4];
+        std::vector<_Range> ranges;
+        friend struct bnf::_Image;
     public:
-	    interval_set()
-	        {   insert(std::make_pair(0, false)); insert(std::make_pair(WCHAR_MAX, false)); }
-        bool test(wchar_t key) const
-            {   return (--upper_bound(key))->second; }
-        void reset(wchar_t key)
+        enum { maxCode = 0x10FFFF };
+        interval_set()
+            {   memset(ascii, 0, sizeof(ascii)); }
+        bool test(unsigned int key) const
+            {   if (key < 128) return (ascii[key >> 5] >> (key & 31)) & 1;
+                std::vector<_Range>::const_iterator itr =
+                    std::upper_bound(ranges.begin(), ranges.end(), _Range(key, ~0u));
+                return itr != ranges.begin() && (--itr)->second >= key; }
+        void reset(unsigned int key)
             {   set(key, 0, false); }
-        void set(wchar_t key, size_t rep = 0, bool val = true)
-            {   wchar_t key_end = key + rep + 1;
-                if (key == 0 || key_end == WCHAR_MAX) return;
-                std::map<wchar_t,bool>::iterator right_begin = lower_bound(key);
-                std::map<wchar_t,bool>::iterator left_begin = right_begin; --left_begin;
-                std::map<wchar_t,bool>::iterator right_end = upper_bound(key_end);
-                std::map<wchar_t,bool>::iterator left_end = right_end; --left_end;
-                if (left_end->second == val)
-                    if (left_end->first >= key_end && right_begin == left_end) erase(right_begin);
-                    else  erase(right_begin, right_end);
-                else {
-                    std::map<wchar_t,bool>::iterator itr = insert(std::make_pair(key_end, left_end->second)).first;
-                    if(right_begin->first < itr->first)
-                            erase(right_begin, itr);  }
-                if (left_begin->second != val)
-                    insert(std::make_pair(key, val));  }
+        void set(unsigned int key, size_t rep = 0, bool val = true) // characters key...key+rep
+            {   unsigned int last = key + rep < (unsigned int)maxCode? key + rep : (unsigned int)maxCode;
+                for (; key < 128 && key <= last; key++) {
+                    if (val) ascii[key >> 5] |= 1u << (key & 31);
+                    else ascii[key >> 5] &= ~(1u << (key & 31)); }
+                if (key > last) return;
+                std::vector<_Range> res;
+                for (size_t i = 0; i < ranges.size(); i++) {
+                    if (ranges[i].second < key || ranges[i].first > last) {
+                        res.push_back(ranges[i]); continue; }
+                    if (ranges[i].first < key) res.push_back(_Range(ranges[i].first, key - 1));
+                    if (ranges[i].second > last) res.push_back(_Range(last + 1, ranges[i].second)); }
+                if (val) res.push_back(_Range(key, last));
+                std::sort(res.begin(), res.end());
+                ranges.clear();
+                for (size_t i = 0; i < res.size(); i++) { // merge adjacent ranges
+                    if (!ranges.size() || ranges.back().second + 1 < res[i].first) ranges.push_back(res[i]);
+                    else if (ranges.back().second < res[i].second) ranges.back().second = res[i].second; } }
+        interval_set& operator|=(const interval_set& other)
+            {   for (int i = 0; i < 4; i++) {
+                    ascii[i] |= other.ascii[i]; }
+                for (size_t i = 0; i < other.ranges.size(); i++) {
+                    set(other.ranges[i].first, other.ranges[i].second - other.ranges[i].first); }
+                return *this; }
+        bool narrow() const // only ASCII characters
+            {   return !ranges.size(); }
         void flip()
-            {   for (std::map<wchar_t, bool>::iterator itr = begin(); itr != end(); ++itr)
-                       itr->second = !itr->second;  }
+            {   std::vector<_Range> res; unsigned int next = 128;
+                for (int i = 0; i < 4; i++) {
+                    ascii[i] = ~ascii[i]; }
+                for (size_t i = 0; i < ranges.size(); next = ranges[i++].second + 1) {
+                    if (ranges[i].first > next) res.push_back(_Range(next, ranges[i].first - 1)); }
+                if (next <= maxCode) res.push_back(_Range(next, maxCode));
+                ranges.swap(res); }
     };
 
- protected: friend class _Tie;
+ protected: friend class _Tie; friend struct _Op; friend struct _Span; friend class Program;
+            friend class _Cycle; friend class _Inspector; friend struct _Nfa; friend struct _Static;
+            friend struct _Image; friend class Rule;
 #if defined(BNFLITE_WIDE)
-    interval_set match;
+    typedef interval_set Set;
 #else
-    std::bitset<bnf::maxCharNum> match;
+    typedef std::bitset<bnf::maxCharNum> Set;
 #endif
+    Set match;
     explicit Token(const Token* tkn) :_Tie(tkn), match(tkn->match)
         {};
-    virtual int _parse(_Base* parser) const throw()
+    template <class N> static int _run(const N& n, _Base* parser)
         {   const char* cc = parser->cntxV.back();
             if (parser->level)
-                cc = parser->zero_parse(cc);
-            char c = *((unsigned char*)cc);
-            if (match.test(c)) {
-                if (parser->level) {
+                cc = parser->_skip(cc);
+            if (cc == parser->pend)
+                return parser->_end(eEof);
+            const char* nx = cc;
+            if (n.match.test(_symbol(nx, parser->pend))) {
+                if (parser->level)
                     parser->cntxV.push_back(cc);
-                    parser->_stub_call(parser->cntxV.size() - 1, name.c_str()); }
-                parser->cntxV.push_back(++cc);
-                return  c ? eOk : eOk|eEof; }
-            return c ? eNone : eEof; }
+                parser->cntxV.push_back(nx);
+                if (parser->level)
+                    parser->_stub_call(parser->cntxV.size() - 2, n.name.c_str());
+                return eOk; }
+            return eNone; }
+    static unsigned int _scan(const Set& match, const char*& cc, const char* end, unsigned int max) // run of characters
+        {   unsigned int i = 0;
+            for (const char* nx = cc; i < max && cc != end && match.test(_symbol(nx, end)); cc = nx) {
+                i++; }
+            return i; }
+    virtual int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
 public:
-    Token(const char c) :_Tie(std::string(1, c))
-        {   Add(c, 0); };    // create single char token
-    Token(int fst, int lst) :_Tie(std::string(1, fst).append("-") += lst)
+    Token(const char c) :_Tie(std::string(1, c), kToken)
+        {   Add((unsigned char)c, 0); };    // create single char token
+    Token(int fst, int lst) :_Tie(std::string(1, fst).append("-") += lst, kToken)
         {   Add(fst, lst); };    // create token by ASCII charactes in range
-    Token(const char *s) :_Tie(std::string(s))
+    Token(const char *s) :_Tie(std::string(s), kToken)
         {   Add(s); }; // create token by C string sample
-    Token(const char *s, const Token& token) :_Tie(std::string(s)), match(token.match)
+    Token(const char *s, const Token& token) :_Tie(std::string(s), kToken), match(token.match)
         {   Add(s); }; // create token by both C string sample and another token set
     Token(const Token& token) :_Tie(token), match(token.match)
         {};
@@ -314,19 +742,28 @@ public:
         {   switch (lst) { // lst == 0|1: add single | upper&lower case character(s)
             case 1: if (fst >= 'A' && fst <= 'Z') match.set(fst - 'A' + 'a');
                     else if (fst >= 'a' && fst <= 'z') match.set(fst - 'a' + 'A');
+#if defined(BNFLITE_WIDE)
+            case 0: match.set(fst); break;
+            default: match.set(fst, lst - fst);
+#else
             case 0: match.set((unsigned char)fst); break;
             default: for (int i = fst; i <= lst; i++) {
                         match.set((unsigned char)i); }
+#endif
                      Remove(sample); } }
-    void Add(const char *sample)
-        {   while (*sample) {
-                match.set((unsigned char)*sample++); } }
+    void Add(const char *sample) // characters of sample, UTF-8 for BNFLITE_WIDE
+        {   for (const char* end = sample + strlen(sample); sample != end; ) {
+                match.set(_symbol(sample, end)); } }
     void Remove(int fst, int lst = 0)
+#if defined(BNFLITE_WIDE)
+        {   match.set(fst, (lst? lst : fst) - fst, false); }
+#else
         {   for (int i = fst; i <= (lst?lst:fst); i++) {
                 match.reset((unsigned char)i); } }
+#endif
     void Remove(const char *sample)
-        {   while (*sample) {
-                match.reset((unsigned char)*sample++); } }
+        {   for (const char* end = sample + strlen(sample); sample != end; ) {
+                match.reset(_symbol(sample, end)); } }
     int GetSymbol(int next = 1) // get first short symbol
         {   for (unsigned int i = next; i < maxCharNum; i++) {
                 if (match.test(i)) return i; }
@@ -344,16 +781,23 @@ inline Token operator""_T(const char* sample, size_t len)
 class Action: public _Tie
 {
     bool (*action)(const char* lexem, size_t len);
+    bool (*user_action)(const char* lexem, size_t len, void* user);
     Action(_Tie&);
-protected:  friend class _Tie;
-    explicit Action(const Action* a) :_Tie(a), action(a->action)
+protected:  friend class _Tie; friend struct _Op; friend class Program; friend class _Inspector;
+            friend struct _Static;
+    explicit Action(const Action* a) :_Tie(a), action(a->action), user_action(a->user_action)
         {};
-    int _parse(_Base* parser) const throw()
+    template <class N> static int _run(const N& n, _Base* parser)
         {   std::vector<const char*>::reverse_iterator itr = parser->cntxV.rbegin() + 1;
-            return (*action)(*itr, parser->cntxV.back() - *itr); }
+            return n.action? (*n.action)(*itr, parser->cntxV.back() - *itr)
+                : (*n.user_action)(*itr, parser->cntxV.back() - *itr, parser->user); }
+    int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
 public:
     Action(bool (*action)(const char* lexem, size_t len), const char *name = "")
-        :_Tie(name), action(action) {};
+        :_Tie(name, kAction), action(action), user_action(0) {};
+    Action(bool (*action)(const char* lexem, size_t len, void* user), const char *name = "")
+        :_Tie(name, kAction), action(0), user_action(action) {}; // gets Options::user of Analyze call
     virtual ~Action()
         {   _safe_delete(this); }
 };
@@ -361,15 +805,17 @@ public:
 /* internal class to support conjunction constructions of BNFlite elements */
 class _And: public _Tie
 {
-protected: friend class _Tie; friend class Lexem;
-    _And(const _Tie& b1, const _Tie& b2):_Tie("")
-        {   (name = b1.name).append("+") += b2.name; _clue(b1); _clue(b2); }
+protected: friend class _Tie; friend class Lexem; friend struct _Op; friend struct _Static;
+    _And(const _Tie& b1, const _Tie& b2):_Tie("", kAnd)
+        {   _clue(b1); _clue(b2); }
     explicit _And(const _And* rl) :_Tie(rl)
         {};
     virtual int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
+    template <class N> static int _run(const N& n, _Base* parser)
         {   int stat = 0; size_t save = 0; size_t size = parser->cntxV.size();
-            for (unsigned i = 0; i < use.size(); i++, stat &= ~(eSkip|eOk)) {
-                stat |= use[i]->_parse(parser);
+            for (unsigned i = 0; i < n.use.size(); i++, stat &= ~(eSkip|eOk)) {
+                stat |= n.use[i]->_parse(parser);
                 if (!(stat & eOk) || (stat & eError) || ((stat & eEof) && (parser->cntxV.back() == parser->cntxV[size - 1]))) {
                     if (parser->level && (stat & eTry) && !(stat & eError) && !save) {
                         stat |= parser->catch_error(parser->cntxV.back()); }
@@ -386,13 +832,16 @@ public:
     ~_And()
         {   _safe_delete(this); }
     _And& operator+(const _Tie& rule2)
-        {   name.append("+") += rule2.name; _clue(rule2); return *this; }
+        {   _clue(rule2); return *this; }
     _And& operator+(const char* s)
-        {   name.append("+") += s; _clue(Token(s)); return *this; }
+        {   _clue(Token(s)); return *this; }
     _And& operator+(bool (*f)(const char*, size_t))
-        {   name += "+()"; _clue(Action(f)); return *this; }
+        {   _clue(Action(f)); return *this; }
+    _And& operator+(bool (*f)(const char*, size_t, void*))
+        {   _clue(Action(f)); return *this; }
     friend _And operator+(const char* s, const _Tie& link);
     friend _And operator+(bool (*f)(const char*, size_t), const _Tie& link);
+    friend _And operator+(bool (*f)(const char*, size_t, void*), const _Tie& link);
 };
 inline _And _Tie::operator+(const _Tie& rule2)
     {   return _And(*this, rule2); }
@@ -400,27 +849,37 @@ inline _And _Tie::operator+(const char* s)
     {   return _And(*this, Token(s)); }
 inline _And _Tie::operator+(bool (*f)(const char*, size_t))
     {   return _And(*this, Action(f)); }
+inline _And _Tie::operator+(bool (*f)(const char*, size_t, void*))
+    {   return _And(*this, Action(f)); }
 inline _And operator+(const char* s, const _Tie& link)
     {   return _And(Token(s), link); }
 inline _And operator+(bool (*f)(const char*, size_t), const _Tie& link)
     {   return _And(Action(f), link); }
+inline _And operator+(bool (*f)(const char*, size_t, void*), const _Tie& link)
+    {   return _And(Action(f), link); }
 
 /* internal class to support disjunction constructions of BNFlite elements */
 class _Or: public _Tie
 {
-protected: friend class _Tie;
-    _Or(const _Tie& b1, const _Tie& b2):_Tie("")
-        {   (name = b1.name).append("|") += b2.name; _clue(b1); _clue(b2); }
+protected: friend class _Tie; friend struct _Op; friend struct _Static;
+    _Or(const _Tie& b1, const _Tie& b2):_Tie("", kOr)
+        {   _clue(b1); _clue(b2); }
     explicit _Or(const _Or* rl) :_Tie(rl)
         {};
     virtual int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
+    template <class N> static int _run(const N& n, _Base* parser)
         {   int stat = 0; int tstat = 0; int max = 0; int tmp = -1;
-            size_t size = parser->cntxV.size();
-            for (unsigned i = 0; i < use.size(); i++, stat &= ~(eOk|eRet|eEof|eError)) {
+            if (int over = parser->_step())
+                return over;
+            size_t size = parser->cntxV.size(); int c = n._predict(parser);
+            for (unsigned i = 0; i < n.use.size(); i++, stat &= ~(eOk|eRet|eEof|eError)) {
+                if (!n.use[i]->_first(parser, c))
+                    continue;
                 size_t msize = parser->cntxV.size();
                 if (msize > size) {
                     parser->cntxV.push_back(parser->cntxV[size - 1]); }
-                stat |= use[i]->_parse(parser);
+                stat |= n.use[i]->_parse(parser);
                 if (stat & (eOk|eError)) {
                     tmp = parser->cntxV.back() - parser->cntxV[size - 1];
                     if ((tmp > max) || (tmp > 0 && (stat & (eRet|e1st))) || (tmp >= 0 && (stat & eError))) {
@@ -428,7 +887,7 @@ protected: friend class _Tie;
                         tstat = stat;
                         if (msize > size) {
                             parser->_erase(size, msize + 1); }
-                        if (stat & (eRet|e1st|eError)) {
+                        if (stat & (eRet|e1st|eCut|eError)) {
                             break; }
                         continue; } }
                 if (parser->cntxV.size() > msize) {
@@ -438,13 +897,16 @@ public:
     ~_Or()
         {   _safe_delete(this); }
     _Or& operator|(const _Tie& rule2)
-        {   name.append("|") += rule2.name; _clue(rule2); return *this; }
+        {   _clue(rule2); return *this; }
     _Or& operator|(const char* s)
-        {   name.append("|") += s; _clue(Token(s)); return *this; }
+        {   _clue(Token(s)); return *this; }
     _Or& operator|(bool (*f)(const char*, size_t))
-        {   name += "|()"; _clue(Action(f)); return *this; }
+        {   _clue(Action(f)); return *this; }
+    _Or& operator|(bool (*f)(const char*, size_t, void*))
+        {   _clue(Action(f)); return *this; }
     friend _Or operator|(const char* s, const _Tie& link);
     friend _Or operator|(bool (*f)(const char*, size_t), const _Tie& link);
+    friend _Or operator|(bool (*f)(const char*, size_t, void*), const _Tie& link);
 };
 inline _Or _Tie::operator|(const _Tie& rule2)
     {   return _Or(*this, rule2); }
@@ -452,40 +914,56 @@ inline _Or _Tie::operator|(const char* s)
     {   return _Or(*this, Token(s)); }
 inline _Or _Tie::operator|(bool (*f)(const char*, size_t))
     {   return _Or(*this, Action(f)); }
+inline _Or _Tie::operator|(bool (*f)(const char*, size_t, void*))
+    {   return _Or(*this, Action(f)); }
 inline _Or operator|(const char* s, const _Tie& link)
     {   return _Or(Token(s), link); }
 inline _Or operator|(bool (*f)(const char*, size_t), const _Tie& link)
     {   return _Or(Action(f), link); }
-inline bool _Tie::_is_compound()
-    {   return dynamic_cast<_And*>(this) || dynamic_cast<_Or*>(this); }
+inline _Or operator|(bool (*f)(const char*, size_t, void*), const _Tie& link)
+    {   return _Or(Action(f), link); }
 
 
 /* interface class for lexem */
 class Lexem: public _Tie
 {
+    bool memo;
     Lexem& operator=(const class Rule&);
     Lexem(const Rule& rule);
-protected: friend class _Tie;
-    explicit Lexem(Lexem* lxm) :_Tie(lxm)
+protected: friend class _Tie; friend struct _Op; friend class Program; friend struct _Static;
+    explicit Lexem(Lexem* lxm) :_Tie(lxm), memo(lxm->memo)
         {};
-    virtual int _parse(_Base* parser) const throw()
-        {   if (!use.size())
+    template <class N> static int _run(const N& n, _Base* parser)
+        {   if (!n.use.size())
                 return eError|eBadLexem;
-            if (!parser->level || dynamic_cast<const Action*>(use[0]))
-                return use[0]->_parse(parser);
+            if (!parser->level || n.use[0]->kind == kAction)
+                return n.use[0]->_parse(parser);
+            if (int over = parser->_step())
+                return over;
             size_t size = parser->cntxV.size();
-            parser->cntxV.push_back(parser->zero_parse(parser->cntxV.back()));
+            bool mem = n.memo || parser->memo_all; int stat = eNone;
+#if defined(BNFLITE_PROFILE)
+            _Probe probe(parser, n.name, stat);
+#endif
+            _Base::_Mark mark;
+            if (mem && parser->_memo_get(&n, stat, mark))
+                return stat;
+            parser->cntxV.push_back(parser->_skip(parser->cntxV.back()));
             parser->level--;
-            int stat = use[0]->_parse(parser);
+            stat = n.use[0]->_parse(parser);
             parser->level++;
+            const size_t org = size; // result of the lexem is remembered at its start
             if ((stat & eOk) && parser->cntxV.size() - size > 1) {
-                parser->_stub_call(size - 1, name.c_str());
+                parser->_stub_call(size - 1, n.name.c_str());
                 if (parser->cntxV.back() > parser->pstop) parser->pstop = parser->cntxV.back();
                 parser->cntxV[(++size)++] = parser->cntxV.back(); }
             parser->cntxV.resize(size);
+            if (mem) parser->_memo_put(&n, org, stat, mark);
             return stat; }
+    virtual int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
 public:
-    Lexem(const char *literal, bool cs = 0) :_Tie()
+    Lexem(const char *literal, bool cs = 0) :_Tie("", kLexem), memo(false)
         {   int size = strlen(literal);
             switch (size) {
             case 1: this->operator=(Token(literal[0], cs));
@@ -496,55 +974,84 @@ public:
                     _and.operator+((const _Tie&)Token(literal[i], cs)); }
                 this->operator=(_and); } }
             _setname(this, literal);  }
-    explicit Lexem() :_Tie()
+    explicit Lexem() :_Tie("", kLexem), memo(false)
         {   _setname(this); }
     virtual ~Lexem()
         {   _safe_delete(this); }
-    Lexem(const _Tie& link) :_Tie()
+    Lexem(const _Tie& link) :_Tie("", kLexem), memo(false)
         {   _setname(this, 0); _clue(link); }
     Lexem& operator=(const Lexem& lexem)
         {   if (&lexem != this) _clue(lexem);
             return *this; }
     Lexem& operator=(const _Tie& link)
         {   _clue(link); return *this; }
+    Lexem& Memoize(bool on = true) // remember results by input position (packrat parsing)
+        {   memo = on; return *this; }
 };
 
 /* interface class for BNF rules */
 class Rule : public _Tie
 {
     void* callback;
-protected:  friend class _Tie; friend class _And;
-    explicit Rule(const Rule* rl) :_Tie(rl), callback(rl->callback)
+    bool memo;
+    bool sync;          // syntax error is skipped up to one of synchronization characters
+    Token::Set match;   // synchronization characters
+protected:  friend class _Tie; friend class _And; friend struct _Op; friend class Program;
+            friend struct _Static;
+    explicit Rule(const Rule* rl) :_Tie(rl), callback(rl->callback), memo(rl->memo), sync(rl->sync), match(rl->match)
     {};
-    virtual int _parse(_Base* parser) const throw()
-        {   if (!use.size() || !parser->level)
+    template <class N> static int _run(const N& n, _Base* parser)
+        {   if (!n.use.size() || !parser->level)
                 return eError|eBadRule;
-            if (dynamic_cast<const Action*>(use[0])) {
-                return use[0]->_parse(parser); }
+            if (n.use[0]->kind == kAction) {
+                return n.use[0]->_parse(parser); }
+            if (int over = parser->_step())
+                return over;
             size_t size = parser->cntxV.size();
-            std::pair<void*, int> up = parser->_pre_call(callback);
-            int stat = use[0]->_parse(parser);
+            bool mem = n.memo || parser->memo_all; int stat = eNone;
+#if defined(BNFLITE_PROFILE)
+            _Probe probe(parser, n.name, stat);
+#endif
+            _Base::_Mark mark;
+            if (mem && parser->_memo_get(&n, stat, mark))
+                return stat;
+            const char* top = parser->pstop;
+            if (n.sync) parser->pstop = parser->cntxV.back(); // to find the furthest point of the rule
+            std::pair<void*, int> up = parser->_pre_call(n.callback, n.name.c_str());
+            stat = n.use[0]->_parse(parser);
+            const size_t org = size; // result of the rule is remembered at its start
             if ((stat & eOk) && parser->cntxV.size() - size > 1) {
-                parser->_do_call(up, callback, size, name.c_str());
+                parser->_do_call(up, n.callback, size, n.name.c_str());
                 if (parser->cntxV.back() > parser->pstop) parser->pstop = parser->cntxV.back(); 
                 parser->cntxV[(++size)++] = parser->cntxV.back(); }
             parser->cntxV.resize(size);
-            parser->_post_call(up);
+            parser->_post_call(up, stat);
+            if (n.sync && !(stat & (eOk|eOver|eBudget|eBadRule|eBadLexem))) { // callback is not called for skipped text
+                stat = parser->_recover(n.match, size, parser->pstop, n.name, stat); }
+            if (n.sync && top > parser->pstop) parser->pstop = top;
+            if (mem) parser->_memo_put(&n, org, stat, mark);
             return stat; }
+    virtual int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
 public:
-    explicit Rule() :_Tie(), callback(0)
+    explicit Rule() :_Tie("", kRule), callback(0), memo(false), sync(false)
         {   _setname(this); }
     virtual ~Rule()
         {   _safe_delete(this); }
-    Rule(const _Tie& link) :_Tie(), callback(0)
+    Rule(const _Tie& link) :_Tie("", kRule), callback(0), memo(false), sync(false)
         {   const Rule* rl = dynamic_cast<const Rule*>(&link);
-            if (rl) { _clone(&link);  callback = rl->callback; name = rl->name; }
+            if (rl) { _clone(&link);  callback = rl->callback; memo = rl->memo; name = rl->name;
+                      sync = rl->sync; match = rl->match; }
             else { _clue(link);   callback = 0; _setname(this);  } }
     Rule& operator=(const _Tie& link)
         {   _clue(link); return *this; }
     Rule& operator=(const Rule& rule)
         {   if (&rule == this) return *this;
             return this->operator=((const _Tie&)rule); }
+    Rule& Memoize(bool on = true) // remember results by input position (packrat parsing)
+        {   memo = on; return *this; }
+    Rule& Recover(const Token& sync) // on syntax error skip text up to sync character (e.g. "\n" or ";"),
+        {   this->sync = true; match = sync.match; return *this; } // the error is put to Options::faults
     template <class U> friend Rule& Bind(Rule& rule, U (*callback)(std::vector<U>&));
     template <class U> Rule& operator[](U (*callback)(std::vector<U>&));
 };
@@ -558,21 +1065,48 @@ class _Cycle: public _Tie
 {
     unsigned int min, max;
     int flag;
-protected: friend class _Tie;
+protected: friend class _Tie; friend struct _Op; friend class Program; friend class _Inspector;
+           friend struct _Static;
     explicit _Cycle(const _Cycle* u) :_Tie(u), min(u->min), max(u->max), flag(u->flag)
         {};
     _Cycle(const _Cycle& w) :_Tie(w), min(w.min), max(w.max), flag(w.flag)
         {};
-    int _parse(_Base* parser) const throw()
+    unsigned int _bulk(_Base* parser, const char*& cc, int& eof) const // scan token repetition in lexem at once
+        {   if (parser->level || use[0]->kind != kToken)
+                return ~0u;
+            eof = eEof;
+            const Token::Set& match = static_cast<const Token*>(use[0])->match;
+            if (match.test(0))
+                return ~0u;
+            return Token::_scan(match, cc, parser->pend, max); }
+    template <class N> static int _run(const N& n, _Base* parser)
         {   int stat; unsigned int i;
-            for (stat = 0, i = 0; i < max; i++, stat &= ~(e1st|eTry|eSkip|eRet|eOk)) {
-                stat |= use[0]->_parse(parser);
-                if ((stat & (eOk|eError)) == eOk)
-                    continue;
-                return i < min? stat & ~eOk : stat | parser->_chk_stack() | eOk; }
-            return stat | flag | eOk; }
+            if (int over = parser->_step())
+                return over;
+            const char* cc = parser->cntxV.back();
+            if ((i = n._bulk(parser, cc, stat)) != ~0u) { // one span for the whole run of characters
+                if (i) parser->cntxV.push_back(cc);
+                if (i == n.max) return n.flag | eOk;
+                if (cc < parser->pend) stat = eNone;
+                else parser->tail = true;
+                return i < n.min? stat : stat | parser->_chk_stack() | eOk; }
+            size_t size = parser->cntxV.size();
+            for (stat = 0, i = 0; i < n.max; i++, stat &= ~(e1st|eTry|eSkip|eRet|eOk|eCut)) {
+                if (n.use[0]->_first(parser, n._predict(parser)))
+                    stat |= n.use[0]->_parse(parser);
+                if ((stat & (eOk|eError)) == eOk) {
+                    if ((stat & eCut) && parser->level && parser->cntxV.size() > size + 2) { // keep the last result only
+                        const char* org = parser->cntxV[size];                  // and the start of text
+                        parser->_erase(size, parser->cntxV.size() - 2);
+                        parser->cntxV[size] = org; }
+                    continue; }
+                stat &= ~eCut;
+                return i < n.min? stat & ~eOk : stat | parser->_chk_stack() | eOk; }
+            return stat | n.flag | eOk; }
+    int _parse(_Base* parser) const throw()
+        {   return _run(*this, parser); }
     _Cycle(int at_least, const _Tie& link, int total = maxRepeate, int limit = maxRepeate)
-        :_Tie(std::string("@")), min(at_least), max(total), flag(total < limit? eNone : eOver|eError)
+        :_Tie(std::string("@"), kCycle), min(at_least), max(total), flag(total < limit? eNone : eOver|eError)
         {   _clue(link); }
 public:
     ~_Cycle()
@@ -597,25 +1131,864 @@ inline _Cycle Iterate(int at_least, const Lexem& lexem, int total = maxLexemLeng
 inline _Cycle Series(int at_least, const Token& token, int total = maxLexemLength, int limit = maxCharNum)
     {   return _Cycle(at_least, token, total, limit); }
 
+/* token set prepared for bulk scan of character repetition (SSE2/AVX2 if available) */
+struct _Span
+{
+    enum { maxRange = 4 };
+    unsigned char tbl[maxCharNum];              // lookup table of the set
+    unsigned char lo[maxRange], len[maxRange];  // ranges of the set for SSE2 compares
+    int num;                                    // number of ranges
+    unsigned char nib[3][16];                   // nibble tables for AVX2 shuffles
+    explicit _Span(const Token::Set& match) :num(0)
+        {   memset(nib, 0, sizeof(nib));
+            for (int i = 0; i < maxCharNum; i++) {
+                tbl[i] = match.test(i);
+                if (!tbl[i]) continue;
+                if (!tbl[i - 1]) {
+                    if (num < maxRange) { lo[num] = i; len[num] = 0; }
+                    num++; }
+                else if (num <= maxRange) len[num - 1]++;
+                nib[i >> 7][i & 15] |= 1 << ((i >> 4) & 7); }
+            for (int i = 0; i < 16; i++) {
+                nib[2][i] = 1 << (i & 7); } }
+    unsigned int _scan(const char* ptr, unsigned int max) const // length of run, NUL is not in the set
+        {   const unsigned char* p = (const unsigned char*)ptr; unsigned int i = 0;
+#if defined(BNFLITE_SIMD) && defined(__AVX2__)
+            const unsigned char* a = (const unsigned char*)((size_t)p & ~(size_t)31);
+            const __m256i ta = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nib[0]));
+            const __m256i tb = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nib[1]));
+            const __m256i th = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nib[2]));
+            const __m256i f = _mm256_set1_epi8(15);
+            for (unsigned int skip = p - a; i < max; a += 32, skip = 0) { // aligned loads stay in page
+                __m256i x = _mm256_load_si256((const __m256i*)a);
+                __m256i l = _mm256_and_si256(x, f);
+                __m256i h = _mm256_and_si256(_mm256_srli_epi16(x, 4), f);
+                __m256i b = _mm256_blendv_epi8(_mm256_shuffle_epi8(ta, l), _mm256_shuffle_epi8(tb, l), x);
+                b = _mm256_and_si256(b, _mm256_shuffle_epi8(th, h));
+                unsigned int miss = _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_setzero_si256())) & (~0u << skip);
+                if (miss) { i += _ctz(miss) - skip; break; }
+                i += 32 - skip; }
+            return i < max? i : max;
+#elif defined(BNFLITE_SIMD)
+            if (num <= maxRange) {
+                const unsigned char* a = (const unsigned char*)((size_t)p & ~(size_t)15);
+                for (unsigned int skip = p - a; i < max; a += 16, skip = 0) { // aligned loads stay in page
+                    __m128i x = _mm_load_si128((const __m128i*)a);
+                    __m128i m = _mm_setzero_si128();
+                    for (int r = 0; r < num; r++) {
+                        __m128i d = _mm_subs_epu8(_mm_sub_epi8(x, _mm_set1_epi8(lo[r])), _mm_set1_epi8(len[r]));
+                        m = _mm_or_si128(m, _mm_cmpeq_epi8(d, _mm_setzero_si128())); }
+                    unsigned int miss = ~_mm_movemask_epi8(m) & (0xFFFFu << skip) & 0xFFFFu;
+                    if (miss) { i += _ctz(miss) - skip; break; }
+                    i += 16 - skip; }
+                return i < max? i : max; }
+#endif
+            while (i < max && tbl[p[i]]) {
+                i++; }
+            return i; }
+};
+
+/* longest match automaton of regular lexem built by Program, state 0 is dead and state 1 is initial */
+struct _Dfa
+{
+    unsigned char cls[maxCharNum];      // class of character
+    unsigned int num;                   // number of classes
+    std::vector<unsigned short> next;   // transitions by state * num + class
+    std::vector<char> fin;              // state completes the lexem
+    unsigned int limit;                 // longer scans are left to backtracking because of repetition limits
+    int (*slow)(const _Op& op, _Base* parser); // backtracking handler of the same element
+};
+
+/* compiled grammar element: flat copy of _Tie node with precomputed kind and inline data */
+struct _Op
+{
+    struct _Links
+    {   const _Op* const* ptr; unsigned int num;
+        unsigned int size() const { return num; }
+        const _Op* operator[](unsigned int i) const { return ptr[i]; } };
+    int kind;
+    int flag;
+    unsigned int min, max;
+    bool memo;
+    bool sync;          // rule recovers from syntax error by synchronization characters of match
+    _Links use;
+    typedef std::bitset<maxCharNum> _Bytes;
+    Token::Set match;
+    _Bytes first;       // bytes to start the element
+    bool null;          // element can be passed without input or can not be predicted
+    bool pred;          // some of subelements can be skipped by FIRST set
+    bool (*action)(const char* lexem, size_t len);
+    bool (*user_action)(const char* lexem, size_t len, void* user);
+    void* callback;
+    std::string name;
+    const _Tie* node;   // foreign element to be parsed by virtual call
+    const _Span* span;  // prepared set of repeated character
+    const _Dfa* dfa;    // automaton of regular lexem body
+    _Op(): kind(_Tie::kTie), flag(0), min(0), max(0), memo(false), sync(false), null(true), pred(false),
+        action(0), user_action(0), callback(0), node(0), span(0), dfa(0), exec(0)
+        {   use.ptr = 0; use.num = 0; }
+    int (*exec)(const _Op& op, _Base* parser);  // handler of the element kind
+    static int _char(const _Op& op, _Base* parser) // token inside lexem, no pre-parsing
+        {   const char* cc = parser->cntxV.back();
+            if (cc == parser->pend)
+                return parser->_end(op.flag);
+            if (op.match.test(_symbol(cc, parser->pend))) {
+                parser->cntxV.push_back(cc);
+                return eOk; }
+            return eNone; }
+    static int _dfa(const _Op& op, _Base* parser) // regular lexem body in one pass without backtracking
+        {   const _Dfa& d = *op.dfa;
+            const unsigned char* cc = (const unsigned char*)parser->cntxV.back(); const unsigned char* last = 0;
+            const unsigned char* end = cc + ((size_t)(parser->pend - (const char*)cc) < d.limit?
+                parser->pend - (const char*)cc : d.limit);
+            for (unsigned int s = 1; s; s = d.next[s * d.num + d.cls[*cc++]]) {
+                if (d.fin[s]) last = cc;
+                if (cc == end) // result can depend on the end of text or on the limit, so flags are set by backtracking
+                    return d.slow(op, parser); }
+            if (!last) return eNone;
+            parser->cntxV.push_back((const char*)last);
+            return eOk; }
+    static int _ctrl(const _Op& op, _Base* parser)
+        {   return op.flag; }
+    static int _tie(const _Op& op, _Base* parser)
+        {   return op.node->_parse(parser); }
+    static int _unbound(const _Op&, _Base*) // action of loaded Program without function
+        {   return eError|eBadRule; }
+    void _bind()
+        {   switch (kind) {
+            case _Tie::kChar:   exec = _char; break;
+            case _Tie::kToken:  exec = Token::_run<_Op>; break;
+            case _Tie::kAnd:    exec = _And::_run<_Op>; break;
+            case _Tie::kOr:     exec = _Or::_run<_Op>; break;
+            case _Tie::kCycle:  exec = _Cycle::_run<_Op>; break;
+            case _Tie::kLexem:  exec = Lexem::_run<_Op>; break;
+            case _Tie::kRule:   exec = Rule::_run<_Op>; break;
+            case _Tie::kAction: exec = action || user_action? Action::_run<_Op> : _unbound; break;
+            case _Tie::kCtrl:   exec = _ctrl; break;
+            default:            exec = _tie; } }
+    int _parse(_Base* parser) const throw()
+        {   return exec(*this, parser); }
+    unsigned int _bulk(_Base* parser, const char*& cc, int& eof) const
+        {   if (span) {
+                eof = use[0]->flag; unsigned int i = span->_scan(cc, (size_t)(parser->pend - cc) < max? parser->pend - cc : max);
+                cc += i; return i; }
+#if defined(BNFLITE_WIDE)
+            if (use[0]->kind == _Tie::kChar && !use[0]->match.test(0)) {
+                eof = use[0]->flag; return Token::_scan(use[0]->match, cc, parser->pend, max); }
+#endif
+            return ~0u; }
+    static bool _narrow(const Token::Set& match) // no code point beyond ASCII, so bytes are characters
+#if defined(BNFLITE_WIDE)
+        {   return match.narrow(); }
+#else
+        {   return true; }
+#endif
+    static _Bytes _bytes(const Token::Set& match) // bytes to start the characters of the set
+#if defined(BNFLITE_WIDE)
+        {   _Bytes res;
+            for (int i = 0; i < maxCharNum; i++) {
+                if (i < 128? match.test(i) : !match.narrow()) res.set(i); }
+            return res; }
+#else
+        {   return match; }
+#endif
+    int _predict(_Base* parser) const // next character to be checked by FIRST sets
+        {   if (!pred) return 0;
+            const char* cc = parser->cntxV.back();
+            if (parser->level) cc = parser->_skip(cc);
+            return cc < parser->pend? *(unsigned char*)cc : 0; }
+    bool _first(_Base* parser, int c) const
+        {   if (null || !c || first.test(c)) return true;
+            parser->pruned++; return false; }
+};
+
+/* automaton of regular lexem body (characters, Null, sequences, alternatives, repetitions) to be determinized; */
+/* 'accept best' equals longest match while complete match of an element can not be continued by the next one */
+struct _Nfa
+{
+    enum { maxStates = 4096, maxDfa = 1024, maxUnroll = 8 };
+    std::vector<_Op::_Bytes> match;         // characters of the state, none for epsilon state
+    std::vector<int> out;                   // state after the character
+    std::vector<std::vector<int> > eps;     // epsilon transitions
+    std::vector<const _Op*> path;           // elements under construction, recursion is not regular
+    std::map<const _Op*, _Op::_Bytes>& conts; // characters to continue complete match of element
+    unsigned int limit;                     // shortest limit of repetitions
+    explicit _Nfa(std::map<const _Op*, _Op::_Bytes>& c) :conts(c), limit(~0u)
+        {};
+    int _state(int nxt = -1)
+        {   match.push_back(_Op::_Bytes()); out.push_back(nxt); eps.push_back(std::vector<int>());
+            return (int)match.size() - 1; }
+    bool _greedy(const _Op* op, const _Op::_Bytes& next) // longest match of op is not continued by next characters
+        {   std::map<const _Op*, _Op::_Bytes>::iterator itr = conts.find(op);
+            if (itr == conts.end()) {
+                itr = conts.insert(std::make_pair(op, _Op::_Bytes().set())).first;
+                _Nfa sub(conts); _Dfa dfa; _Op::_Bytes cont;
+                sub.path = path;
+                int fin = sub._state(), s = sub._build(op, fin);
+                if (s >= 0 && sub._subset(s, fin, dfa, &cont))
+                    itr->second = cont; }
+            return (itr->second & next).none(); }
+    int _build(const _Op* op, int nxt) // entry state of element followed by nxt, -1 if it is not regular
+        {   if (nxt < 0 || match.size() > maxStates || std::find(path.begin(), path.end(), op) != path.end())
+                return -1;
+            int s = -1; path.push_back(op);
+            switch (op->kind) {
+            case _Tie::kChar:  if (_Op::_narrow(op->match)) { s = _state(nxt); match[s] = _Op::_bytes(op->match); } break;
+            case _Tie::kCtrl:  if (op->flag == eOk) s = nxt; break;
+            case _Tie::kAnd:   s = nxt;
+                for (unsigned j = op->use.size(); j-- > 0 && s >= 0; ) {
+                    _Op::_Bytes first; // FIRST set of the rest of sequence
+                    for (unsigned k = j + 1; k < op->use.size(); k++) {
+                        first |= op->use[k]->first;
+                        if (!op->use[k]->null) break; }
+                    s = first.none() || _greedy(op->use[j], first)? _build(op->use[j], s) : -1; } break;
+            case _Tie::kOr:    s = _state();
+                for (unsigned j = 0; j < op->use.size() && s >= 0; j++) {
+                    int e = _build(op->use[j], nxt);
+                    if (e < 0) s = -1; else eps[s].push_back(e); } break;
+            case _Tie::kCycle: {
+                const _Op* body = op->use[0]; int t = nxt;
+                if (body->null || op->min > maxUnroll || (op->max > 1 && !_greedy(body, body->first)))
+                    break;
+                if (op->max > maxUnroll || (op->flag & eError)) { // loop, longer scans are checked by backtracking
+                    if (op->max < limit) limit = op->max;
+                    int e = _build(body, t = _state());
+                    eps[t].push_back(e); eps[t].push_back(nxt);
+                    if (e < 0) break; }
+                else for (unsigned i = op->min; i < op->max && t >= 0; i++) {
+                    int c = _state(), e = _build(body, t);
+                    eps[c].push_back(e); eps[c].push_back(nxt);
+                    t = e < 0? -1 : c; }
+                for (unsigned i = 0; i < op->min && t >= 0; i++) {
+                    t = _build(body, t); }
+                s = t; } break; }
+            path.pop_back();
+            return s; }
+    void _closure(std::vector<int>& set, std::vector<char>& mark) // sorted states reachable by epsilon transitions
+        {   for (size_t i = 0; i < set.size(); i++) {
+                for (size_t j = 0; j < eps[set[i]].size(); j++) {
+                    if (!mark[eps[set[i]][j]]) { mark[eps[set[i]][j]] = 1; set.push_back(eps[set[i]][j]); } } }
+            for (size_t i = 0; i < set.size(); i++) {
+                mark[set[i]] = 0; }
+            std::sort(set.begin(), set.end());
+            set.erase(std::unique(set.begin(), set.end()), set.end()); }
+    bool _subset(int start, int fin, _Dfa& d, _Op::_Bytes* cont) // subset construction by classes of characters
+        {   int ids[maxCharNum][2]; unsigned char rep[maxCharNum] = {0};
+            memset(d.cls, 0, sizeof(d.cls)); d.num = 1;
+            for (size_t s = 0; s < match.size(); s++) {
+                if (match[s].none()) continue;
+                memset(ids, -1, sizeof(ids)); d.num = 0;
+                for (int c = 0; c < maxCharNum; c++) {
+                    int& id = ids[d.cls[c]][match[s].test(c)];
+                    if (id < 0) { id = d.num++; rep[id] = c; }
+                    d.cls[c] = id; } }
+            std::vector<char> mark(match.size());
+            std::vector<std::vector<int> > sets(2, std::vector<int>(1, start));
+            std::map<std::vector<int>, unsigned int> index;
+            sets[0].clear(); _closure(sets[1], mark); index[sets[1]] = 1;
+            d.next.assign(d.num, 0); d.fin.assign(1, 0); d.limit = limit;
+            for (size_t k = 1; k < sets.size(); k++) {
+                d.fin.push_back(std::binary_search(sets[k].begin(), sets[k].end(), fin));
+                for (unsigned int c = 0; c < d.num; c++) {
+                    std::vector<int> to;
+                    for (size_t i = 0; i < sets[k].size(); i++) {
+                        if (match[sets[k][i]].test(rep[c])) {
+                            if (!mark[out[sets[k][i]]]) to.push_back(out[sets[k][i]]);
+                            mark[out[sets[k][i]]] = 1; } }
+                    _closure(to, mark);
+                    unsigned int t = 0;
+                    if (to.size()) {
+                        std::map<std::vector<int>, unsigned int>::iterator itr = index.find(to);
+                        if (itr == index.end()) {
+                            if (sets.size() >= maxDfa) return false;
+                            itr = index.insert(std::make_pair(to, (unsigned int)sets.size())).first;
+                            sets.push_back(to); }
+                        t = itr->second; }
+                    d.next.push_back(t);
+                    for (int i = 0; cont && t && d.fin[k] && i < maxCharNum; i++) {
+                        if (d.cls[i] == c) cont->set(i); } } }
+            return true; }
+};
+
+/* Read-only view of whole file: memory mapped if supported, otherwise read to memory */
+/* (always read and terminated by NUL for pre-parser which does not know end of text) */
+class _File
+{
+    const char* data;
+    size_t size;
+    std::vector<char> copy;
+    _File(const _File&);
+    _File& operator=(const _File&);
+public:
+    explicit _File(const char* path, bool nul = false) :data(0), size(0)
+        {
+#if defined(BNFLITE_MMAP)
+            if (!nul) {
+                int fd = open(path, O_RDONLY); struct stat st;
+                if (fd >= 0 && !fstat(fd, &st)) {
+                    size = st.st_size; data = "";
+                    void* ptr = size? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+                    if (ptr != MAP_FAILED) data = (const char*)ptr;
+                    else if (size) data = 0; }
+                if (fd >= 0) close(fd);
+                return; }
+#endif
+            FILE* file = fopen(path, "rb");
+            if (!file) return;
+            char buf[0x10000];
+            for (size_t len; (len = fread(buf, 1, sizeof(buf), file)) != 0; ) {
+                copy.insert(copy.end(), buf, buf + len); }
+            fclose(file);
+            size = copy.size(); copy.push_back(0); data = &copy[0]; }
+    ~_File()
+        {
+#if defined(BNFLITE_MMAP)
+            if (data && size && !copy.size()) munmap((void*)data, size);
+#endif
+        }
+    const char* begin() const
+        {   return data; }
+    const char* end() const
+        {   return data + size; }
+};
+
+/* internal binary image of Program: little-endian 32-bit words, strings and tables are led by size */
+struct _Image
+{
+    enum { magic = 0x4C464E42, version = 1 }; // "BNFL"
+    std::string out;
+    const unsigned char* ptr;
+    const unsigned char* end;
+    explicit _Image(const char* image = 0, size_t size = 0)
+        :ptr((const unsigned char*)image), end((const unsigned char*)image + size) {};
+    static unsigned int _config() // build options changing the image
+        {
+#if defined(BNFLITE_WIDE)
+            return maxCharNum << 1 | 1;
+#else
+            return maxCharNum << 1;
+#endif
+        }
+    static unsigned int _hash(const unsigned char* p, const unsigned char* e) // FNV-1a by words against damaged images
+        {   unsigned int h = 2166136261u;
+            for (; e - p >= 4; p += 4) h = (h ^ (p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24)) * 16777619u;
+            for (; p < e; p++) h = (h ^ *p) * 16777619u;
+            return h; }
+    bool _check() // the last word is hash of the image, the image is trusted as code otherwise
+        {   if (end - ptr < 4) return false;
+            end -= 4;
+            return (end[0] | end[1] << 8 | end[2] << 16 | (unsigned int)end[3] << 24) == _hash(ptr, end); }
+    void _put(unsigned int v)
+        {   for (int i = 0; i < 32; i += 8) out += (char)(v >> i); }
+    void _put(const std::string& s)
+        {   _put(s.size()); out += s; }
+    void _put_chars(const Token::Set& match) // ranges of characters
+        {   std::vector<unsigned int> r;
+#if defined(BNFLITE_WIDE)
+            unsigned int n = 128;
+#else
+            unsigned int n = maxCharNum;
+#endif
+            for (unsigned int i = 0; i < n; i++) {
+                if (match.test(i) && (!i || !match.test(i - 1))) r.push_back(i);
+                if (match.test(i) && (i + 1 == n || !match.test(i + 1))) r.push_back(i); }
+#if defined(BNFLITE_WIDE)
+            for (size_t i = 0; i < match.ranges.size(); i++) {
+                r.push_back(match.ranges[i].first); r.push_back(match.ranges[i].second); }
+#endif
+            _put(r.size() / 2);
+            for (size_t i = 0; i < r.size(); i++) _put(r[i]); }
+    void _put(const std::bitset<maxCharNum>& bits)
+        {   for (int i = 0; i < maxCharNum; i += 32) {
+                unsigned int v = 0;
+                for (int j = 0; j < 32; j++) v |= (unsigned int)bits.test(i + j) << j;
+                _put(v); } }
+    bool _get(unsigned int& v)
+        {   if (end - ptr < 4) return false;
+            v = ptr[0] | ptr[1] << 8 | ptr[2] << 16 | (unsigned int)ptr[3] << 24;
+            ptr += 4; return true; }
+    bool _get(std::string& s)
+        {   unsigned int n;
+            if (!_get(n) || (size_t)(end - ptr) < n) return false;
+            s.assign((const char*)ptr, n); ptr += n; return true; }
+    bool _get_chars(Token::Set& match)
+        {   unsigned int n, lo, hi;
+            if (!_get(n)) return false;
+            while (n--) {
+#if defined(BNFLITE_WIDE)
+                if (!_get(lo) || !_get(hi) || lo > hi || hi > Token::interval_set::maxCode) return false;
+                match.set(lo, hi - lo);
+#else
+                if (!_get(lo) || !_get(hi) || lo > hi || hi >= (unsigned int)maxCharNum) return false;
+                match |= (~Token::Set() >> (maxCharNum - 1 - (hi - lo))) << lo;
+#endif
+            }
+            return true; }
+    bool _get(std::bitset<maxCharNum>& bits)
+        {   unsigned int v;
+            for (int i = 0; i < maxCharNum; i += 32) {
+                if (!_get(v)) return false;
+                bits |= std::bitset<maxCharNum>(v) << i; }
+            return true; }
+};
+
+/* Grammar frozen into contiguous array of elements to be parsed without virtual calls; */
+/* elements are specialized by lexem/rule level, pass-through lexems are skipped */
+/* Build it from the root of completed grammar and pass to Analyze instead of the root */
+class Program: public _Tie
+{
+    typedef std::map<std::pair<const _Tie*, int>, size_t> _Index;
+    std::vector<_Op> ops;
+    std::vector<const _Op*> links;
+    std::list<_Span> spans;
+    std::list<_Dfa> dfas;
+    std::vector<size_t> slots; // Rules with callbacks and Actions to be bound after loading
+    Program(const Program&);
+    Program& operator=(const Program&);
+    size_t _compile(const _Tie* n, int lvl, _Index& idx, std::vector<std::vector<size_t> >& sub)
+        {   for (int i = 0; i < maxRepeate && n->use.size() && n->use[0] &&
+                    ((n->kind == kLexem && (!lvl || n->use[0]->kind == kAction)) ||
+                    (n->kind == kRule && lvl && n->use[0]->kind == kAction)); i++) {
+                n = n->use[0]; }
+            _Index::iterator itr = idx.find(std::make_pair(n, lvl));
+            if (itr != idx.end())
+                return itr->second;
+            size_t k = ops.size(); int sublvl = lvl;
+            idx[std::make_pair(n, lvl)] = k;
+            ops.push_back(_Op()); sub.push_back(std::vector<size_t>());
+            _Op& op = ops.back();
+            op.kind = n->kind; op.name = n->name;
+            switch (n->kind) {
+            case kToken:  op.match = static_cast<const Token*>(n)->match;
+                          if (!lvl) { op.kind = kChar; op.flag = eEof; } break;
+            case kAction: op.action = static_cast<const Action*>(n)->action;
+                          op.user_action = static_cast<const Action*>(n)->user_action; break;
+            case kCycle:  op.min = static_cast<const _Cycle*>(n)->min;
+                          op.max = static_cast<const _Cycle*>(n)->max;
+                          op.flag = static_cast<const _Cycle*>(n)->flag; break;
+            case kLexem:  op.memo = static_cast<const Lexem*>(n)->memo; sublvl = 0; break;
+            case kRule:   op.memo = static_cast<const Rule*>(n)->memo;
+                          op.callback = static_cast<const Rule*>(n)->callback;
+                          op.sync = static_cast<const Rule*>(n)->sync; op.match = static_cast<const Rule*>(n)->match;
+                          if (!lvl) { op.kind = kCtrl; op.flag = eError|eBadRule; return k; } break;
+            case kCtrl:   op.flag = n->_parse(0); break;
+            case kAnd: case kOr: break;
+            default:      op.node = n; return k; }
+            bool chars = n->kind == kOr && !lvl;
+            for (size_t j = 0; j < n->use.size(); j++) {
+                size_t c = _compile(n->use[j], sublvl, idx, sub);
+                chars = chars && ops[c].kind == kChar;
+                sub[k].push_back(c); }
+            if (chars) { // fold alternative of characters to one character set
+                for (size_t j = 0; j < sub[k].size(); j++) {
+                    ops[k].match |= ops[sub[k][j]].match; }
+                ops[k].kind = kChar; ops[k].flag = eNone; sub[k].clear(); }
+            return k; }
+    void _first() // FIRST sets and nullability of elements up to fixed point
+        {   _Op::_Bytes any; any.set();
+            for (size_t i = 0; i < ops.size(); i++) {
+                _Op& op = ops[i];
+                switch (op.kind) {
+                case kToken: case kChar: op.first = _Op::_bytes(op.match); op.null = false; break;
+                case kCtrl:  op.null = true; // Null and Skip only, other controls are not predictable
+                             op.first = op.flag == eOk || op.flag == (eOk|eSkip)? _Op::_Bytes() : any; break;
+                case kAnd: case kOr: case kCycle: op.null = false; break;
+                case kLexem: case kRule: op.null = !op.use.size() || op.sync; // recovery is not predictable
+                             op.first = op.null? any : _Op::_Bytes(); break;
+                default:     op.null = true; op.first = any; } }
+            for (bool done = false; !done; ) {
+                done = true;
+                for (size_t i = 0; i < ops.size(); i++) {
+                    _Op& op = ops[i]; _Op::_Bytes first; bool null = false;
+                    switch (op.kind) {
+                    case kAnd:   null = true;
+                                 for (unsigned j = 0; j < op.use.size() && null; j++) {
+                                    first |= op.use[j]->first; null = op.use[j]->null; } break;
+                    case kOr:    for (unsigned j = 0; j < op.use.size(); j++) {
+                                    first |= op.use[j]->first; null = null || op.use[j]->null; } break;
+                    case kCycle: first = op.use[0]->first; null = !op.min || op.use[0]->null; break;
+                    case kLexem: case kRule:
+                                 if (!op.use.size() || op.sync) continue;
+                                 first = op.use[0]->first; null = op.use[0]->null; break;
+                    default:     continue; }
+                    if (first != op.first || null != op.null) {
+                        op.first = first; op.null = null; done = false; } } }
+            for (size_t i = 0; i < ops.size(); i++) {
+                for (unsigned j = 0; j < ops[i].use.size() && (ops[i].kind == kOr || ops[i].kind == kCycle); j++) {
+                    ops[i].pred = ops[i].pred || !ops[i].use[j]->null; } } }
+    void _link(const std::vector<std::vector<size_t> >& sub)
+        {   for (size_t i = 0; i < sub.size(); i++) {
+                for (size_t j = 0; j < sub[i].size(); j++) {
+                    links.push_back(&ops[sub[i][j]]); } }
+            for (size_t i = 0, j = 0; i < ops.size(); j += sub[i++].size()) {
+                ops[i].use.ptr = links.size()? &links[0] + j : 0;
+                ops[i].use.num = sub[i].size();
+                ops[i]._bind(); }
+            for (size_t i = 0; i < ops.size(); i++) { // repetition of character set to be scanned in bulk
+                if (ops[i].kind == kCycle && ops[i].use[0]->kind == kChar && !ops[i].use[0]->match.test(0)
+                    && _Op::_narrow(ops[i].use[0]->match)) {
+                    spans.push_back(_Span(ops[i].use[0]->match));
+                    ops[i].span = &spans.back(); } } }
+    bool _load(_Image& img, std::vector<std::vector<size_t> >& sub, std::vector<unsigned int>& dfa)
+        {   unsigned int v, n, k;
+            if (!img._check() || !img._get(v) || v != _Image::magic || !img._get(v) || v != _Image::version
+                    || !img._get(v) || v != _Image::_config() || !img._get(n)) return false;
+            for (; n; n--) {
+                dfas.push_back(_Dfa()); _Dfa& d = dfas.back();
+                if ((size_t)(img.end - img.ptr) < sizeof(d.cls)) return false;
+                memcpy(d.cls, img.ptr, sizeof(d.cls)); img.ptr += sizeof(d.cls);
+                if (!img._get(d.num) || !d.num || !img._get(k) || (size_t)(img.end - img.ptr) / 2 < k) return false;
+                d.next.reserve(k);
+                for (; k; k--, img.ptr += 2) d.next.push_back(img.ptr[0] | img.ptr[1] << 8);
+                if (!img._get(k) || (size_t)(img.end - img.ptr) < k) return false;
+                d.fin.assign(img.ptr, img.ptr + k); img.ptr += k;
+                if (!img._get(d.limit) || d.fin.size() < 2 || d.next.size() != d.fin.size() * d.num) return false;
+                for (size_t i = 0; i < sizeof(d.cls); i++) if (d.cls[i] >= d.num) return false;
+                for (size_t i = 0; i < d.next.size(); i++) if (d.next[i] >= d.fin.size()) return false; }
+            if (!img._get(n) || n > (size_t)(img.end - img.ptr) / 64) return false; // an element takes 17 words at least
+            ops.resize(n); sub.resize(n); dfa.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                _Op& op = ops[i];
+                if (!img._get(v) || v < kCtrl || v > kChar || v == kTie) return false;
+                op.kind = v;
+                if (!img._get(v) || !img._get(op.min) || !img._get(op.max) || !img._get(k)) return false;
+                op.flag = v; op.memo = k & 1; op.null = (k >> 1) & 1; op.pred = (k >> 2) & 1; op.sync = (k >> 3) & 1;
+                if (!img._get(op.name) || !img._get_chars(op.match) || !img._get(op.first)
+                        || !img._get(dfa[i]) || dfa[i] > dfas.size() || !img._get(k)) return false;
+                for (; k; k--) {
+                    if (!img._get(v) || v >= n) return false;
+                    sub[i].push_back(v); }
+                if ((op.kind == kCycle && sub[i].size() != 1) || ((op.kind == kRule || op.kind == kLexem) && sub[i].size() > 1)
+                        || ((op.kind == kToken || op.kind == kChar || op.kind == kAction || op.kind == kCtrl) && sub[i].size())) return false; }
+            if (!img._get(n)) return false;
+            for (; n; n--) {
+                if (!img._get(v) || v >= ops.size() || (ops[v].kind != kRule && ops[v].kind != kAction)) return false;
+                slots.push_back(v); }
+            return img.ptr == img.end; }
+    static bool _set(_Op& op, bool (*action)(const char*, size_t))
+        {   if (op.kind != kAction) return false;
+            op.action = action; op.user_action = 0; op._bind(); return true; }
+    static bool _set(_Op& op, bool (*action)(const char*, size_t, void*))
+        {   if (op.kind != kAction) return false;
+            op.action = 0; op.user_action = action; op._bind(); return true; }
+    template <class U> static bool _set(_Op& op, U (*callback)(std::vector<U>&))
+        {   if (op.kind != kRule) return false;
+            op.callback = reinterpret_cast<void*>(callback); return true; }
+    void _open(const char* image, size_t size)
+        {   _Image img(image, size); std::vector<std::vector<size_t> > sub; std::vector<unsigned int> dfa;
+            if (!_load(img, sub, dfa)) {
+                ops.clear(); dfas.clear(); slots.clear(); return; }
+            name = ops.size()? ops[0].name : "";
+            _link(sub);
+            std::vector<_Dfa*> tbl;
+            for (std::list<_Dfa>::iterator itr = dfas.begin(); itr != dfas.end(); ++itr) {
+                tbl.push_back(&*itr); }
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (!dfa[i]) continue;
+                tbl[dfa[i] - 1]->slow = ops[i].exec;
+                ops[i].exec = _Op::_dfa; ops[i].dfa = tbl[dfa[i] - 1]; } }
+public:
+    explicit Program(const _Tie& root) :_Tie(root.name)
+        {   _Index idx; std::vector<std::vector<size_t> > sub;
+            _compile(&root, 1, idx, sub);
+            _link(sub);
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (ops[i].kind == kAction || (ops[i].kind == kRule && ops[i].callback)) slots.push_back(i); }
+            _first();
+#if !defined(BNFLITE_NO_DFA)
+            std::map<const _Op*, _Op::_Bytes> conts;
+            for (size_t i = 0; i < ops.size(); i++) { // regular lexem bodies to be matched by automaton
+                if (ops[i].kind != kLexem || !sub[i].size()) continue;
+                _Op& body = ops[sub[i][0]]; bool scan = body.kind == kChar || body.span || body.kind == kAnd;
+                for (unsigned j = 0; j < body.use.size() && body.kind == kAnd && scan; j++) { // no backtracking
+                    scan = body.use[j]->kind == kChar || body.use[j]->span; }
+                if (body.dfa || body.null || scan) continue;
+                _Nfa nfa(conts); dfas.push_back(_Dfa());
+                int fin = nfa._state(), s = nfa._build(&body, fin);
+                if (s < 0 || !nfa._subset(s, fin, dfas.back(), 0)) {
+                    dfas.pop_back(); continue; }
+                dfas.back().slow = body.exec;
+                body.exec = _Op::_dfa; body.dfa = &dfas.back(); }
+#endif
+        }
+protected:
+    virtual int _parse(_Base* parser) const throw()
+        {   return ops.size()? ops[0]._parse(parser) : eError|eBadRule; }
+public:
+    Program(const char* image, size_t size) :_Tie("") // image made by Save(), Size() is 0 for wrong one
+        {   _open(image, size); }
+    explicit Program(const char* path) :_Tie("") // image file is memory mapped if supported
+        {   _File file(path); _open(file.begin(), file.end() - file.begin()); }
+    size_t Size() const     // number of compiled elements
+        {   return ops.size(); }
+    bool Save(std::string& image) const // versioned image to be loaded by Program(image, size), callbacks are not saved
+        {   _Image img; std::map<const _Dfa*, unsigned int> num;
+            img._put(_Image::magic); img._put(_Image::version); img._put(_Image::_config());
+            img._put(dfas.size());
+            unsigned int k = 0;
+            for (std::list<_Dfa>::const_iterator itr = dfas.begin(); itr != dfas.end(); ++itr) {
+                num[&*itr] = ++k;
+                img.out.append((const char*)itr->cls, sizeof(itr->cls)); img._put(itr->num);
+                img._put(itr->next.size());
+                for (size_t i = 0; i < itr->next.size(); i++) {
+                    img.out += (char)itr->next[i]; img.out += (char)(itr->next[i] >> 8); }
+                img._put(itr->fin.size()); img.out.append(itr->fin.begin(), itr->fin.end());
+                img._put(itr->limit); }
+            img._put(ops.size());
+            for (size_t i = 0; i < ops.size(); i++) {
+                const _Op& op = ops[i];
+                if (op.node) return false; // foreign elements are not in the image
+                img._put(op.kind); img._put(op.flag); img._put(op.min); img._put(op.max);
+                img._put(op.memo | op.null << 1 | op.pred << 2 | op.sync << 3);
+                img._put(op.name); img._put_chars(op.match); img._put(op.first);
+                img._put(op.dfa? num[op.dfa] : 0);
+                img._put(op.use.size());
+                for (unsigned j = 0; j < op.use.size(); j++) {
+                    img._put(op.use[j] - &ops[0]); } }
+            img._put(slots.size());
+            for (size_t i = 0; i < slots.size(); i++) {
+                img._put(slots[i]); }
+            img._put(_Image::_hash((const unsigned char*)img.out.data(), (const unsigned char*)img.out.data() + img.out.size()));
+            image.swap(img.out);
+            return true; }
+    bool Save(const char* path) const
+        {   std::string image; FILE* file;
+            if (!Save(image) || (file = fopen(path, "wb")) == 0) return false;
+            bool res = fwrite(image.data(), 1, image.size(), file) == image.size();
+            return fclose(file) == 0 && res; }
+    std::vector<std::string> Slots() const // names of Rules with callbacks and of Actions, the index is slot number
+        {   std::vector<std::string> res;
+            for (size_t i = 0; i < slots.size(); i++) {
+                res.push_back(ops[slots[i]].name); }
+            return res; }
+    template <class F> int Bind(const char* name, F f) // callback or action by element name, returns number of slots
+        {   int n = 0;
+            for (size_t i = 0; i < slots.size(); i++) {
+                n += ops[slots[i]].name == name && _set(ops[slots[i]], f); }
+            return n; }
+    template <class F> bool Bind(int slot, F f)
+        {   return slot >= 0 && (size_t)slot < slots.size() && _set(ops[slots[slot]], f); }
+};
+
+/* internal class to keep grammar graph of Grammar and to release it with recursive Rules */
+class _Graph
+{
+protected:
+    Rule root;
+    template <class F> explicit _Graph(F build)
+        {   build(root); }
+    ~_Graph()
+        {   _Tie::_release(&root); }
+};
+
+/* grammar built once by user function (void build(Rule& root)) and compiled to Program, */
+/* it is shared by parsing calls and threads, the graph can not be changed after building */
+class Grammar: private _Graph, public Program
+{
+    Grammar(const Grammar&);
+    Grammar& operator=(const Grammar&);
+public:
+    template <class F> explicit Grammar(F build) :_Graph(build), Program(root)
+        {}
+};
+
+/* finding of grammar inspection: construction expensive for backtracking or never used */
+struct Issue
+{
+    enum Kind { iEmptyLoop, iLeftRecursion, iCommonPrefix, iShadowed, iUnreachable };
+    enum Cost { cNone, cLinear, cExponential, cUnbounded }; // worst-case parse time against text length
+    int kind;
+    int cost;
+    std::string rule;   // name of the nearest Rule or Lexem containing the construction
+    std::string text;   // description of the construction
+    Issue(int knd, int cst, const std::string& rl, const std::string& txt)
+        :kind(knd), cost(cst), rule(rl), text(txt) {};
+};
+
+/* internal class to walk the grammar graph without parsing */
+class _Inspector
+{
+    typedef std::vector<const _Tie*> _Seq;
+    std::map<const _Tie*, const _Tie*> owner;   // reachable element and its nearest Rule or Lexem
+    std::map<const _Tie*, bool> null;           // reachable element can match empty text
+    std::vector<const _Tie*> order;
+    std::set<const _Tie*> done;                 // disjunctions unfolded into outer ones
+    static bool _named(const _Tie* n)
+        {   return n->kind == _Tie::kRule || n->kind == _Tie::kLexem; }
+    void _add(int kind, int cost, const _Tie* n, const std::string& text)
+        {   issues.push_back(Issue(kind, cost, owner[n]->name, text)); }
+    void _walk(const _Tie* root)
+        {   std::vector<std::pair<const _Tie*, const _Tie*> > stack(1, std::make_pair(root, root));
+            while (stack.size()) {
+                const _Tie* n = stack.back().first; const _Tie* own = stack.back().second;
+                stack.pop_back();
+                if (owner.count(n)) continue;
+                owner[n] = own; order.push_back(n);
+                for (size_t i = n->use.size(); i-- > 0; ) {
+                    if (n->use[i]) stack.push_back(std::make_pair(n->use[i], _named(n->use[i])? n->use[i] : own)); } } }
+    bool _nullable(const _Tie* n)
+        {   switch (n->kind) {
+            case _Tie::kToken: return false;
+            case _Tie::kCtrl: return (n->_parse(0) & eOk) != 0;
+            case _Tie::kCycle: return static_cast<const _Cycle*>(n)->min == 0 || null[n->use[0]];
+            case _Tie::kAnd: for (size_t i = 0; i < n->use.size(); i++) {
+                                 if (n->use[i] && !null[n->use[i]]) return false; }
+                             return true;
+            case _Tie::kOr: for (size_t i = 0; i < n->use.size(); i++) {
+                                if (n->use[i] && null[n->use[i]]) return true; }
+                            return false;
+            case _Tie::kLexem: case _Tie::kRule: return n->use.size() && n->use[0] && null[n->use[0]];
+            default: return true; } }
+    bool _left(const _Tie* n, const _Tie* target, std::set<const _Tie*>& seen) // target can be called at the same position
+        {   if (!seen.insert(n).second) return false;
+            for (size_t i = 0; i < n->use.size() && n->use[i]; i++) {
+                if (n->use[i] == target || _left(n->use[i], target, seen)) return true;
+                if (n->kind != _Tie::kOr && (n->kind != _Tie::kAnd || !null[n->use[i]])) break; }
+            return false; }
+    static bool _reach(const _Tie* n, const _Tie* target, std::set<const _Tie*>& seen)
+        {   if (n == target) return true;
+            if (!n || !seen.insert(n).second) return false;
+            for (size_t i = 0; i < n->use.size(); i++) {
+                if (_reach(n->use[i], target, seen)) return true; }
+            return false; }
+    static void _flat(const _Tie* n, int kind, _Seq& seq, int lxm = 0) // unfold nested compounds (and lexems)
+        {   if (n && lxm && n->kind == _Tie::kLexem && n->use.size() && n->use[0] && n->use[0]->kind != _Tie::kAction) {
+                _flat(n->use[0], kind, seq, lxm - 1); }
+            else if (n && n->kind == kind) {
+                for (size_t i = 0; i < n->use.size(); i++) {
+                    _flat(n->use[i], kind, seq, lxm); } }
+            else seq.push_back(n); }
+    static bool _same(const _Tie* a, const _Tie* b, bool cover) // a matches the same text as b, or any of b text
+        {   if (a == b) return true;
+            if (!a || !b || a->kind != b->kind) return false;
+            switch (a->kind) {
+#if !defined(BNFLITE_WIDE)
+            case _Tie::kToken: {
+                const Token::Set& ma = static_cast<const Token*>(a)->match;
+                const Token::Set& mb = static_cast<const Token*>(b)->match;
+                return cover? (mb & ~ma).none() : ma == mb; }
+#endif
+            case _Tie::kAction: return static_cast<const Action*>(a)->action == static_cast<const Action*>(b)->action
+                                    && static_cast<const Action*>(a)->user_action == static_cast<const Action*>(b)->user_action;
+            case _Tie::kCtrl: return a->_parse(0) == b->_parse(0); }
+            return false; }
+    static std::string _join(const _Seq& seq, size_t k)
+        {   std::string s;
+            for (size_t i = 0; i < k; i++) {
+                (s += i? "+" : "") += seq[i]? seq[i]->_name() : "?"; }
+            return s; }
+    static std::string _num(size_t i)
+        {   char buf[24]; sprintf(buf, "%u", (unsigned)i); return buf; }
+    void _prefix(const _Tie* n, const _Seq& top) // alternatives repeat parsing of common start
+        {   std::vector<_Seq> alt(top.size());
+            for (size_t i = 0; i < top.size(); i++) {
+                _flat(top[i], _Tie::kAnd, alt[i]); }
+            for (size_t i = 0; i < alt.size(); i++) {
+                for (size_t j = i + 1; j < alt.size(); j++) {
+                    size_t k = 0; bool heavy = false; bool loop = false;
+                    for (; k < alt[i].size() && k < alt[j].size() && _same(alt[i][k], alt[j][k], false); k++) {
+                        std::set<const _Tie*> seen;
+                        heavy |= alt[i][k] && alt[i][k]->kind != _Tie::kToken && alt[i][k]->kind != _Tie::kCtrl && alt[i][k]->kind != _Tie::kAction;
+                        loop |= _reach(alt[i][k], n, seen); }
+                    if (!heavy) continue;
+                    _add(Issue::iCommonPrefix, loop? Issue::cExponential : Issue::cLinear, n, "alternatives "
+                        + _num(i + 1) + " and " + _num(j + 1) + " of `" + n->_name() + "` both parse `" + _join(alt[i], k) + "`");
+                    break; } } }
+    void _shadow(const _Tie* n, const _Seq& top) // AcceptFirst never reaches alternative matched by earlier one
+        {   std::vector<_Seq> alt(top.size());
+            for (size_t i = 0; i < top.size(); i++) {
+                _flat(top[i], _Tie::kAnd, alt[i], 8); }
+            for (size_t j = 2; j < alt.size(); j++) {
+                for (size_t i = 1; i < j; i++) {
+                    size_t k = 0;
+                    while (k < alt[i].size() && k < alt[j].size() && _same(alt[i][k], alt[j][k], true)) k++;
+                    if (k < alt[i].size() || !top[i] || null[top[i]]) continue;
+                    _add(Issue::iShadowed, Issue::cNone, n, "alternative `" + _join(alt[j], alt[j].size())
+                        + "` of `" + n->_name() + "` is never tried after `" + _join(alt[i], alt[i].size()) + "`");
+                    break; } } }
+    void _unused() // named elements connected to the grammar but not reachable from its root
+        {   std::vector<const _Tie*> stack(order);
+            std::set<const _Tie*> seen(order.begin(), order.end());
+            while (stack.size()) {
+                const _Tie* n = stack.back(); stack.pop_back();
+                for (std::list<const _Tie*>::const_iterator usg = n->usage.begin(); usg != n->usage.end(); ++usg) {
+                    if (!seen.insert(*usg).second) continue;
+                    stack.push_back(*usg);
+                    if (_named(*usg) && !(*usg)->inner) {
+                        issues.push_back(Issue(Issue::iUnreachable, Issue::cNone, (*usg)->name, "`" + (*usg)->name
+                            + "` is not reachable from `" + order[0]->name + "`")); } } } }
+    static bool _worse(const Issue& a, const Issue& b)
+        {   return a.cost > b.cost; }
+public:
+    std::vector<Issue> issues;
+    explicit _Inspector(const _Tie* root)
+        {   _walk(root);
+            for (bool change = true; change; ) { // fixed point of nullable elements
+                change = false;
+                for (size_t i = order.size(); i-- > 0; ) {
+                    if (!null[order[i]] && _nullable(order[i])) change = null[order[i]] = true; } }
+            for (size_t i = 0; i < order.size(); i++) {
+                const _Tie* n = order[i];
+                std::set<const _Tie*> seen;
+                if (n->kind == _Tie::kCycle && static_cast<const _Cycle*>(n)->max > 1 && null[n->use[0]]) {
+                    _add(Issue::iEmptyLoop, Issue::cUnbounded, n, "repetition of `" + n->use[0]->_name() + "` can match empty text"); }
+                if (_named(n) && _left(n, n, seen)) {
+                    _add(Issue::iLeftRecursion, Issue::cUnbounded, n, "`" + n->name + "` calls itself without consuming text"); }
+                if (n->kind != _Tie::kOr || done.count(n)) continue;
+                _Seq top; _flat(n, _Tie::kOr, top);
+                for (_Seq nest(n->use.begin(), n->use.end()); nest.size(); nest.pop_back()) {
+                    if (nest.back() && nest.back()->kind == _Tie::kOr && done.insert(nest.back()).second) {
+                        nest.insert(nest.begin(), nest.back()->use.begin(), nest.back()->use.end()); } }
+                _prefix(n, top);
+                if (top.size() && top[0] && top[0]->kind == _Tie::kCtrl && (top[0]->_parse(0) & e1st)) {
+                    _shadow(n, top); } }
+            _unused();
+            std::stable_sort(issues.begin(), issues.end(), _worse); }
+};
+
+/* static analysis of grammar graph built from the root: hot spots of backtracking and unused rules */
+inline std::vector<Issue> Inspect(const _Tie& root)
+    {   return _Inspector(&root).issues; }
+
 /* context class to support the second kind of callback */
 template <class U> class _Parser : public _Base
 {
 protected:
     std::vector<U>* cntxU;
     unsigned int off;
+    std::vector<U> memoU;
+    std::vector< std::vector<U>* > frames; // reusable results of lower rules by depth of callbacks
+    size_t depth;
+    _Parser(const _Parser&);
+    _Parser& operator=(const _Parser&);
+    virtual bool _memo_val(int& val, bool save)
+        {   if (!cntxU) return true;
+            if (!save && val < 0) return false;
+#if __cplusplus > 199711L
+            return _memo_val(val, save, std::is_copy_constructible<U>()); }
+    bool _memo_val(int&, bool, std::false_type)
+        {   return true; } // move-only data is not remembered, it is parsed again
+    bool _memo_val(int& val, bool save, std::true_type)
+        {
+#endif
+            if (save) { val = memoU.size(); memoU.push_back(cntxU->back()); }
+            else cntxU->push_back(memoU[val]);
+            return true; }
     void _erase(int low, int up = 0)
         {   cntxV.erase(cntxV.begin() + low,  up? cntxV.begin() + up : cntxV.end() );
             if (cntxU && level)
                 cntxU->erase(cntxU->begin() + (low - off) / 2,
                  up? cntxU->begin() + (up - off) / 2 : cntxU->end()); }
-    virtual std::pair<void*, int> _pre_call(void* callback)
+    virtual std::pair<void*, int> _pre_call(void* callback, const char*)
         {   std::pair<void*, int> up = std::make_pair(cntxU, off);
-            cntxU = callback? new std::vector<U> : 0;
+            if (callback && depth == frames.size()) {
+                frames.push_back(new std::vector<U>); }
+            cntxU = callback? frames[depth++] : 0;
             off = callback? cntxV.size() : 0;
             return up; }
-    virtual void  _post_call(std::pair<void*, int> up)
+    virtual void  _post_call(std::pair<void*, int> up, int)
         {   if (cntxU) {
-                delete cntxU; }
+                cntxU->clear(); depth--; }
             cntxU = (std::vector<U>*)up.first;
             off = up.second; }
     virtual void _do_call(std::pair<void*, int> up, void* callback, size_t org, const char* name)
@@ -630,26 +2003,36 @@ protected:
         {   if (cntxU) {
                 cntxU->push_back(U(cntxV[org], cntxV.back() - cntxV[org], name)); } }
 public:
-    _Parser(const char* (*f)(const char*), std::vector<U>* v) :_Base(f), cntxU(v), off(0)
+    _Parser(const char* (*f)(const char*), std::vector<U>* v, Options* opt = 0) :_Base(f, opt), cntxU(v), off(0),
+        depth(0)
         {};
     virtual ~_Parser()
-        {};
+        {   for (size_t i = 0; i < frames.size(); i++) {
+                delete frames[i]; } }
+    virtual void _reset()
+        {   _Base::_reset(); if (cntxU) cntxU->clear(); off = 0; memoU.clear(); depth = 0; }
     int _get_result(U& u)
-        {   if (cntxU && cntxU->size()) { u.data = cntxU->front().data; return 0; }
+        {   if (cntxU && cntxU->size()) { u.data = BNFLITE_MOVE(cntxU->front().data); return 0; }
             else return eNull; }
     template <class W> friend Rule& Bind(Rule& rule, W (*callback)(std::vector<W>&));
 };
 
-inline int _Base::_analyze(_Tie& root, const char* text, size_t* plen)
-{   cntxV.push_back(text); cntxV.push_back(text);
+inline int _Base::_analyze(_Tie& root, const char* text, const char* end, size_t* plen, bool part)
+{   pend = end? end : text + strlen(text);
+    deadline = timeout > 0? _now() + timeout : 0; over = 0; step_chk = 0;
+    cntxV.push_back(text); cntxV.push_back(text);
     int stat = root._parse(this);
-    const char* ptr = zero_parse(pstop > cntxV.back() ? pstop : cntxV.back());
+#if defined(BNFLITE_PROFILE)
+    _profile_flush();
+#endif
+    const char* ptr = _skip(pstop > cntxV.back() ? pstop : cntxV.back());
     if (plen) *plen = ptr - text;
-    return stat | (*ptr? eError|eRest: 0);  }
+    return (stat & ~eCut) | (ptr < pend && !part? eError|eRest: 0);  }
 
 /* User interface template to support the second kind of callback */
 /* The user need to specify own 'Foo' abstract type to develop own callbaks */
 /* like: Interface<Foo> CallBack(std::vector<Interface<Foo>>& res); */
+/* Elements of 'res' are dropped after the call, so C++11 callbacks can move their data */
 template <typename Data = bool> struct Interface
 {
     Data data;              //  user data element
@@ -659,11 +2042,16 @@ template <typename Data = bool> struct Interface
     Interface(const Interface& ifc, const char* text, size_t length, const char* name)
         :data(ifc.data) , text(text), length(length), name(name)
         {}; // mandatory constructor with user data to be called from library
+#if __cplusplus > 199711L
+    Interface(Interface&& ifc, const char* text, size_t length, const char* name)
+        :data(std::move(ifc.data)), text(text), length(length), name(name)
+        {}; // the same to move user data returned by callback
+#endif
     Interface(const char* text, size_t length,  const char* name)
         :data(), text(text), length(length), name(name)
         {}; //  mandatory default constructor to be called from library
     Interface(Data data, std::vector<Interface>& res, const char* name = "")
-        :data(data), text(res.size()? res[0].text: ""),
+        :data(BNFLITE_MOVE(data)), text(res.size()? res[0].text: ""),
           length(res.size()? res[res.size() - 1].text
             - res[0].text + res[res.size() - 1].length : 0), name(name)
         {}; // constructor to pass data from user's callback to library
@@ -673,27 +2061,324 @@ template <typename Data = bool> struct Interface
     Interface(): data(), text(0), length(0), name(0)
         {}; // default constructor
     static Interface ByPass(std::vector<Interface>& res) // simplest user callback example
-        {   return res.size()? res[0]: Interface(); }   // just to pass data to upper level
+        {   return res.size()? BNFLITE_MOVE(res[0]): Interface(); }   // just to pass data to upper level
     int _get_pstop(const char** pstop)
         {   if (pstop) *pstop = text + length;
             return length ? eNone : eNull; }
 };
 
 /* Private parsing interface */
-template <class U> inline int _Analyze(_Tie& root, U& u, const char* (*pre_parse)(const char*))
+template <class U> inline int _Analyze(_Tie& root, U& u, const char* end, const char* (*pre_parse)(const char*), Options* opt)
     {   if (typeid(U) == typeid(Interface<>)) {
-                    _Base base(pre_parse); return base._analyze(root, u.text, &u.length);
-        } else {    std::vector<U> v; _Parser<U> parser(pre_parse, &v);
-                    return parser._analyze(root, u.text, &u.length) | parser._get_result(u); } }
+                    _Base base(pre_parse, opt); int stat = base._analyze(root, u.text, end, &u.length);
+                    if (opt) { opt->pruned = base.pruned; opt->faults.swap(base.faults); opt->spent = base.steps; }
+                    return stat;
+        } else {    std::vector<U> v; _Parser<U> parser(pre_parse, &v, opt);
+                    int stat = parser._analyze(root, u.text, end, &u.length) | parser._get_result(u);
+                    if (opt) { opt->pruned = parser.pruned; opt->faults.swap(parser.faults); opt->spent = parser.steps; }
+                    return stat; } }
 
 /* Primary interface set to start parsing of text against constructed rules */
-template <class U> inline int Analyze(_Tie& root, const char* text, const char** pstop, U& u, const char* (*pre_parse)(const char*) = 0)
-    {   u.text = text; return _Analyze(root, u, pre_parse) | u._get_pstop(pstop); }
-template <class U> inline int Analyze(_Tie& root, const char* text, U& u, const char* (*pre_parse)(const char*) = 0)
-    {   u.text = text; return _Analyze(root, u, pre_parse) | u._get_pstop(0); }
-inline int Analyze(_Tie& root, const char* text, const char** pstop = 0, const char* (*pre_parse)(const char*) = 0)
-    {   Interface<> u; u.text = text;  return _Analyze(root, u, pre_parse) | u._get_pstop(pstop); }
+template <class U> inline int Analyze(_Tie& root, const char* text, const char** pstop, U& u, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   u.text = text; return _Analyze(root, u, 0, pre_parse, opt) | u._get_pstop(pstop); }
+template <class U> inline int Analyze(_Tie& root, const char* text, U& u, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   u.text = text; return _Analyze(root, u, 0, pre_parse, opt) | u._get_pstop(0); }
+inline int Analyze(_Tie& root, const char* text, const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   Interface<> u; u.text = text;  return _Analyze(root, u, 0, pre_parse, opt) | u._get_pstop(pstop); }
+
+/* The same set for text in range [begin, end), it can contain NUL characters and need not be terminated; */
+/* the name differs, so null pstop of the set above is not taken for end */
+template <class U> inline int AnalyzeRange(_Tie& root, const char* begin, const char* end, const char** pstop, U& u, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   u.text = begin; return _Analyze(root, u, end, pre_parse, opt) | u._get_pstop(pstop); }
+template <class U> inline int AnalyzeRange(_Tie& root, const char* begin, const char* end, U& u, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   u.text = begin; return _Analyze(root, u, end, pre_parse, opt) | u._get_pstop(0); }
+inline int AnalyzeRange(_Tie& root, const char* begin, const char* end, const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   Interface<> u; u.text = begin;  return _Analyze(root, u, end, pre_parse, opt) | u._get_pstop(pstop); }
+
+/* Parse whole file without copy (it is copied for pre_parse argument which needs NUL at the end of text); */
+/* u.length is the length of parsed text, u.text is not valid after the call */
+template <class U> inline int AnalyzeFile(_Tie& root, const char* path, U& u, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   _File file(path, pre_parse && !(opt && opt->pre_parse)); u.text = file.begin();
+        int stat = file.begin()? _Analyze(root, u, file.end(), pre_parse, opt) | u._get_pstop(0) : eError|eNoData;
+        u.text = 0; return stat; }
+inline int AnalyzeFile(_Tie& root, const char* path, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   Interface<> u; return AnalyzeFile(root, path, u, pre_parse, opt); }
+
+/* Base of user's receiver of parsing events instead of Interface results: the user's class hides */
+/* these methods by own ones, they are called directly; spans point into the text, nothing is copied */
+struct Sink
+{
+    void Enter(const char* name, const char* ptr)   // rule is tried at ptr (after pre-parser)
+        {};
+    void Exit(const char* name, const char* text, size_t len, bool ok) // rule is matched or failed (empty span)
+        {};
+    void Match(const char* name, const char* text, size_t len) // token or lexem of rule, or text skipped by Recover()
+        {};
+};
+
+/* Private parser to emit events of rules, tokens and lexems in order of parsing, */
+/* so events of rejected alternatives are also emitted and are completed by failed Exit */
+template <class S> class _Events: public _Base
+{
+    S& sink;
+    bool done;  // Exit of the last rule has been emitted
+    _Events(const _Events&);
+    _Events& operator=(const _Events&);
+protected:
+    virtual bool _memo_val(int&, bool save)
+        {   return save; } // remembered matches are parsed again to emit their events
+    virtual std::pair<void*, int> _pre_call(void*, const char* name)
+        {   sink.Enter(name, _skip(cntxV.back())); done = false;
+            return std::make_pair((void*)name, 0); }
+    virtual void _post_call(std::pair<void*, int> up, int stat)
+        {   if (!done) sink.Exit((const char*)up.first, cntxV.back(), 0, (stat & eOk) != 0);
+            done = false; }
+    virtual void _do_call(std::pair<void*, int>, void*, size_t org, const char* name)
+        {   sink.Exit(name, cntxV[org], cntxV.back() - cntxV[org], true); done = true; }
+    virtual void _stub_call(size_t org, const char* name)
+        {   sink.Match(name, cntxV[org], cntxV.back() - cntxV[org]); }
+public:
+    _Events(const char* (*pre)(const char*), S& sink, Options* opt) :_Base(pre, opt), sink(sink), done(false)
+        {};
+};
+
+/* Parse text in range [begin, end) (end = 0 - up to NUL) by events to sink, callbacks of Rules are not called */
+template <class S> inline int AnalyzeEvents(_Tie& root, const char* begin, const char* end, S& sink,
+                const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   _Events<S> parser(pre_parse, sink, opt); size_t len = 0;
+        int stat = parser._analyze(root, begin, end, &len);
+        if (opt) { opt->pruned = parser.pruned; opt->faults.swap(parser.faults); opt->spent = parser.steps; }
+        if (pstop) *pstop = begin + len;
+        return stat | (len? eNone : eNull); }
+template <class S> inline int AnalyzeEvents(_Tie& root, const char* text, S& sink,
+                const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   return AnalyzeEvents(root, text, 0, sink, pstop, pre_parse, opt); }
+
+/* Parse tree in one array: node 0 is the root, nodes are in preorder, so children follow their parent */
+class Tree
+{
+public:
+    struct Node
+    {
+        const char* name;   // name of rule, lexem or token, it is the same pointer for the same element
+        size_t begin, end;  // offsets of text of the node
+        int child, next;    // first child and next sibling (-1 - none)
+    };
+    std::vector<Node> nodes;
+    const char* text;       // parsed text, it is not copied
+    Tree(): text(0)
+        {};
+    size_t Size() const
+        {   return nodes.size(); }
+    const Node& operator[](int i) const
+        {   return nodes[i]; }
+    std::string Text(int i) const
+        {   return std::string(text + nodes[i].begin, nodes[i].end - nodes[i].begin); }
+    template <class F> F Visit(F f, int root = 0) const // f(*this, node, depth) in preorder,
+        {   std::vector<std::pair<int, int> > stack;     // children are skipped if it returns false
+            if (root < (int)nodes.size()) stack.push_back(std::make_pair(root, 0));
+            while (stack.size()) {
+                int i = stack.back().first, depth = stack.back().second; stack.pop_back();
+                if (i != root && nodes[i].next >= 0) stack.push_back(std::make_pair(nodes[i].next, depth));
+                if (f(*this, i, depth) && nodes[i].child >= 0) stack.push_back(std::make_pair(nodes[i].child, depth + 1)); }
+            return f; }
+};
+
+struct _Kid // index of child node in frame of rule
+{
+    int node;
+    _Kid(int node): node(node) {};
+    _Kid(const _Kid& kid, const char*, size_t, const char*): node(kid.node) {};
+    _Kid(const char*, size_t, const char*): node(-1) {};
+};
+
+/* Private parser to build Tree: each rule has frame of child nodes like callback of _Parser, */
+/* so rejected results are dropped by the same way; nodes are put to arena and flattened at the end */
+class _Tree: public _Parser<_Kid>
+{
+    std::vector<Tree::Node> arena;
+    std::vector<size_t> marks;  // size of arena at start of active rules
+    const char* base;
+    int _node(const char* name, size_t org)
+        {   Tree::Node n = { name, (size_t)(cntxV[org] - base), (size_t)(cntxV.back() - base), -1, -1 };
+            arena.push_back(n); return (int)arena.size() - 1; }
+protected:
+    virtual bool _memo_val(int&, bool save)
+        {   return save; } // nodes of remembered matches can be dropped, so they are parsed again
+    virtual std::pair<void*, int> _pre_call(void*, const char* name)
+        {   marks.push_back(arena.size()); return _Parser<_Kid>::_pre_call((void*)name, name); }
+    virtual void _post_call(std::pair<void*, int> up, int stat)
+        {   if (!(stat & eOk)) arena.resize(marks.back()); // nodes of failed rule
+            marks.pop_back(); _Parser<_Kid>::_post_call(up, stat); }
+    virtual void _do_call(std::pair<void*, int> up, void*, size_t org, const char* name)
+        {   int k = _node(name, org);
+            for (size_t i = 0; i < cntxU->size(); i++) {
+                if (i) arena[(*cntxU)[i - 1].node].next = (*cntxU)[i].node;
+                else arena[k].child = (*cntxU)[i].node; }
+            if (up.first) ((std::vector<_Kid>*)up.first)->push_back(_Kid(k)); }
+    virtual void _stub_call(size_t org, const char* name)
+        {   if (cntxU) cntxU->push_back(_Kid(_node(name, org))); }
+public:
+    _Tree(const char* (*pre)(const char*), std::vector<_Kid>* top, Options* opt) :_Parser<_Kid>(pre, top, opt), base(0)
+        {};
+    int _tree(_Tie& root, const char* text, const char* end, Tree& tree, size_t* plen)
+        {   base = tree.text = text; arena.swap(tree.nodes); arena.clear(); // capacity of previous tree is reused
+            int stat = _analyze(root, text, end, plen);
+            int top = cntxU->size() == 1? (*cntxU)[0].node : -1;
+            if (top < 0) { // several results of root element are children of unnamed node
+                Tree::Node n = { "", 0, *plen, -1, -1 };
+                for (size_t i = cntxU->size(); i-- > 0; ) {
+                    arena[(*cntxU)[i].node].next = n.child; n.child = (*cntxU)[i].node; }
+                arena.push_back(n); top = (int)arena.size() - 1; }
+            tree.nodes.clear(); tree.nodes.reserve(arena.size());
+            std::vector<std::pair<int, int> > stack(1, std::make_pair(top, -1)); // old node, new left sibling or -2 - parent
+            while (stack.size()) { // preorder: node, its subtree, next sibling
+                int i = stack.back().first, k = (int)tree.nodes.size(), left = stack.back().second; stack.pop_back();
+                tree.nodes.push_back(arena[i]); tree.nodes[k].child = tree.nodes[k].next = -1;
+                if (left >= 0) tree.nodes[left].next = k;
+                else if (left < -1) tree.nodes[-2 - left].child = k;
+                if (arena[i].next >= 0 && i != top) stack.push_back(std::make_pair(arena[i].next, k));
+                if (arena[i].child >= 0) stack.push_back(std::make_pair(arena[i].child, -2 - k)); }
+            return stat; }
+};
+
+/* Parse text in range [begin, end) (end = 0 - up to NUL) into Tree, callbacks of Rules are not called */
+inline int AnalyzeTree(_Tie& root, const char* begin, const char* end, Tree& tree,
+                const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   std::vector<_Kid> top; _Tree parser(pre_parse, &top, opt); size_t len = 0;
+        int stat = parser._tree(root, begin, end, tree, &len);
+        if (opt) { opt->pruned = parser.pruned; opt->faults.swap(parser.faults); opt->spent = parser.steps; }
+        if (pstop) *pstop = begin + len;
+        return stat | (len? eNone : eNull); }
+inline int AnalyzeTree(_Tie& root, const char* text, Tree& tree,
+                const char** pstop = 0, const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   return AnalyzeTree(root, text, 0, tree, pstop, pre_parse, opt); }
+
+/* Result of one input of AnalyzeBatch call or one piece of Session */
+template <class U = Interface<> > struct Result
+{
+    int status;         // the same as returned by Analyze
+    const char* pstop;  // the pointer where parser stops
+    U u;                // top Interface object (u.data - final user data)
+    std::vector<Fault> faults; // syntax errors skipped by Rules with Recover()
+};
+
+#if __cplusplus > 199711L
+/* Private part of AnalyzeBatch: range of inputs owned by worker, other workers can steal its half */
+struct _Range { std::mutex lock; size_t lo, hi; };
 
+template <class U> inline size_t _AnalyzeInputs(_Tie& root, const std::vector<const char*>& inputs,
+                std::vector< Result<U> >& results, std::vector<_Range>& ranges, size_t id,
+                const char* (*pre_parse)(const char*), Options* opt)
+    {   std::vector<U> v; _Parser<U> parser(pre_parse, &v, opt); _Base base(pre_parse, opt);
+        _Base& cntx = typeid(U) == typeid(Interface<>)? base : parser; // the same as _Analyze
+        for (;;) {
+            size_t i, num = ranges.size();
+            {   std::lock_guard<std::mutex> lock(ranges[id].lock);
+                i = ranges[id].lo < ranges[id].hi? ranges[id].lo++ : ~(size_t)0; }
+            if (i == ~(size_t)0) { // steal upper half of the largest range
+                size_t vic = id, max = 0;
+                for (size_t k = 0; k < num; k++) {
+                    std::lock_guard<std::mutex> lock(ranges[k].lock);
+                    if (ranges[k].hi - ranges[k].lo > max) { max = ranges[k].hi - ranges[k].lo; vic = k; } }
+                if (!max) break;
+                size_t lo, hi;
+                {   std::lock_guard<std::mutex> lock(ranges[vic].lock);
+                    hi = ranges[vic].hi; lo = ranges[vic].lo + (hi - ranges[vic].lo) / 2;
+                    if (lo >= hi) continue;
+                    ranges[vic].hi = lo; }
+                std::lock_guard<std::mutex> lock(ranges[id].lock);
+                ranges[id].lo = lo; ranges[id].hi = hi;
+                continue; }
+            Result<U>& res = results[i];
+            res.u = U(); res.u.text = inputs[i];
+            cntx._reset();
+            res.status = cntx._analyze(root, inputs[i], 0, &res.u.length)
+                | (&cntx == &parser? parser._get_result(res.u) : 0) | res.u._get_pstop(&res.pstop);
+            res.faults.swap(cntx.faults); }
+        return cntx.pruned; }
+
+/* Parse independent texts by several threads against the same grammar (Rule or Program) */
+/* Results are in input order; returns number of texts with errors (negative status) */
+/* Note: callbacks are called from several threads, Options::user is shared by all of them */
+template <class U> inline size_t AnalyzeBatch(_Tie& root, const std::vector<const char*>& inputs,
+                std::vector< Result<U> >& results, unsigned int threads = 0,
+                const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+    {   results.resize(inputs.size());
+        if (!threads) threads = std::thread::hardware_concurrency();
+        if (threads > inputs.size()) threads = (unsigned int)inputs.size();
+        if (!threads) threads = 1;
+        std::vector<_Range> ranges(threads);
+        for (size_t k = 0; k < threads; k++) {
+            ranges[k].lo = inputs.size() * k / threads; ranges[k].hi = inputs.size() * (k + 1) / threads; }
+        std::vector<size_t> pruned(threads);
+        std::vector<std::thread> pool;
+        for (size_t k = 1; k < threads; k++) {
+            pool.push_back(std::thread([&, k]() {
+                pruned[k] = _AnalyzeInputs(root, inputs, results, ranges, k, pre_parse, opt); })); }
+        pruned[0] = _AnalyzeInputs(root, inputs, results, ranges, 0, pre_parse, opt);
+        for (size_t k = 0; k < pool.size(); k++) {
+            pool[k].join(); }
+        size_t err = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            err += results[i].status < 0; }
+        if (opt) {
+            opt->pruned = 0;
+            for (size_t k = 0; k < threads; k++) opt->pruned += pruned[k]; }
+        return err; }
+#endif
+
+/* Push-style parsing of text coming by chunks: the root is parsed repeatedly as a series of pieces */
+/* (records, lines, statements); each piece is committed as soon as it does not depend on next data */
+template <class U = Interface<> > class Session
+{
+    _Tie& root;
+    void (*commit)(Result<U>& piece, void* user); // called for each piece, its text is valid during the call
+    void* user;
+    std::string buf;    // unconsumed tail of fed data
+    size_t tried;       // size of tail at last attempt which required more data
+    int err;
+    std::vector<U> v;
+    _Parser<U> parser;
+    _Base base;
+    _Base& cntx;
+    Session(const Session&);
+    Session& operator=(const Session&);
+    int _run(bool last)
+        {   size_t done = 0;
+            if (!err && (last || buf.size() >= 2 * tried)) {
+                while (done < buf.size()) {
+                    Result<U> res; res.u.text = buf.c_str() + done;
+                    cntx._reset();
+                    res.status = cntx._analyze(root, res.u.text, buf.c_str() + buf.size(), &res.u.length, true)
+                        | (&cntx == &parser? parser._get_result(res.u) : 0) | res.u._get_pstop(&res.pstop);
+                    if (cntx.tail && !last) {
+                        tried = buf.size() - done; break; } // the piece can be continued by next data
+                    res.faults.swap(cntx.faults);
+                    if (!(res.status & eOk) || !res.u.length) {
+                        res.status |= eError|eRest; }
+                    if (commit) {
+                        commit(res, user); }
+                    if (res.status < 0) {
+                        err = res.status; break; }
+                    done += res.u.length; tried = 0; } }
+            buf.erase(0, done);
+            return err? err : (int)eOk; }
+public:
+    Session(_Tie& root, void (*commit)(Result<U>& piece, void* user) = 0,
+                const char* (*pre_parse)(const char*) = 0, Options* opt = 0)
+        :root(root), commit(commit), user(opt? opt->user : 0), tried(0), err(0),
+        parser(pre_parse, &v, opt), base(pre_parse, opt),
+        cntx(typeid(U) == typeid(Interface<>)? base : parser)
+        {};
+    int Feed(const char* ptr, size_t len) // append next chunk and commit completed pieces
+        {   if (!err) buf.append(ptr, len);
+            return _run(false); }
+    int Finish() // end of data, commit the rest
+        {   return _run(true); }
+    size_t Pending() // size of data waiting for next chunk
+        {   return buf.size(); }
+};
 
 /* Create association between Rule and user's callback */
 template <class U> inline Rule& Bind(Rule& rule, U (*callback)(std::vector<U>&))
@@ -701,6 +2386,386 @@ template <class U> inline Rule& Bind(Rule& rule, U (*callback)(std::vector<U>&))
 template <class U> inline Rule& Rule::operator[](U (*callback)(std::vector<U>&)) // for C++11
     {   this->callback = reinterpret_cast<void*>(callback); return *this; }
 
+#if __cplusplus > 199711L
+/* access of grammar templates (see bnf::ct below) to parse functions of grammar graph */
+struct _Static
+{
+    enum { kToken = _Tie::kToken, kCtrl = _Tie::kCtrl, kAction = _Tie::kAction, kAnd = _Tie::kAnd,
+           kOr = _Tie::kOr, kCycle = _Tie::kCycle, kLexem = _Tie::kLexem, kRule = _Tie::kRule };
+    typedef Token::Set Set;
+    static const Set& _match(const Token& t)
+        {   return t.match; }
+    static const std::string& _name(const _Tie& t)
+        {   return t.name; }
+    template <class N> static int _token(const N& n, _Base* parser)
+        {   return Token::_run(n, parser); }
+    template <class N> static int _action(const N& n, _Base* parser)
+        {   return Action::_run(n, parser); }
+    template <class N> static int _and(const N& n, _Base* parser)
+        {   return _And::_run(n, parser); }
+    template <class N> static int _or(const N& n, _Base* parser)
+        {   return _Or::_run(n, parser); }
+    template <class N> static int _cycle(const N& n, _Base* parser)
+        {   return _Cycle::_run(n, parser); }
+    template <class N> static int _lexem(const N& n, _Base* parser)
+        {   return Lexem::_run(n, parser); }
+    template <class N> static int _rule(const N& n, _Base* parser)
+        {   return Rule::_run(n, parser); }
+    static int _predict(_Base* parser) // next character to be checked by FIRST sets
+        {   const char* cc = parser->cntxV.back();
+            if (parser->level) cc = parser->_skip(cc);
+            return cc < parser->pend? *(unsigned char*)cc : 0; }
+    static unsigned int _bulk(const Set& match, _Base* parser, const char*& cc, int& eof, unsigned int max)
+        {   if (parser->level || match.test(0))
+                return ~0u;
+            eof = eEof;
+            return Token::_scan(match, cc, parser->pend, max); }
+    static int _literal(const std::string& text, bool cs, _Base* parser) // the same as sequence of tokens in lexem
+        {   const char* cc = parser->cntxV.back();
+            for (size_t i = 0; i < text.size(); i++, cc++) {
+                if (cc == parser->pend)
+                    return parser->_end(eEof);
+                if (*cc != text[i] && !(cs && (unsigned char)((*cc | 0x20) - 'a') < 26 && (*cc ^ 0x20) == text[i]))
+                    return eNone; }
+            parser->cntxV.push_back(cc);
+            return eOk; }
+};
+
+/* Grammar of fixed structure built by expression templates: elements are values of distinct types, */
+/* so parse functions are instantiated for them and inlined without virtual calls and heap nodes; */
+/* operators, results and callbacks are the same as for grammar graph, a rule used before its definition */
+/* is declared as Forward and called by pointer, e.g.: */
+/*     ct::Forward expr; */
+/*     auto primary = ct::Rule("(" + expr + ")" | ct::Lexem(1 * ct::Token('0', '9')))[DoPrimary]; */
+/*     auto sum = ct::Rule(primary + *("+-" + primary))[DoSum]; */
+/*     expr = sum; auto root = ct::Root(expr); int tst = Analyze(root, text, u); */
+namespace ct {
+
+template <class A> struct _Cycle;
+
+/* base of grammar templates: FIRST set of the element like _Op of Program, rules defined later are not predicted */
+struct _Expr
+{
+    _Op::_Bytes first;  // bytes to start the element
+    bool null;          // element can be passed without input or can not be predicted
+    bool pred;          // some of subelements can be skipped by FIRST set
+    _Expr() :null(true), pred(false)
+        {   first.set(); }
+    void _seq(const _Expr* const* e, size_t n)
+        {   first.reset(); null = true;
+            for (size_t i = 0; i < n && null; i++) {
+                first |= e[i]->first; null = e[i]->null; } }
+    void _alt(const _Expr* const* e, size_t n)
+        {   first.reset(); null = false;
+            for (size_t i = 0; i < n; i++) {
+                first |= e[i]->first; null = null || e[i]->null; pred = pred || !e[i]->null; } }
+    int _predict(_Base* parser) const
+        {   return pred? _Static::_predict(parser) : 0; }
+    bool _first(_Base* parser, int c) const
+        {   if (null || !c || first.test(c)) return true;
+            parser->pruned++; return false; }
+};
+template <class N> struct _Node: public _Expr
+{
+    typedef N _Item;    // copy of the element to be kept in expressions
+    template <class M = N> _Cycle<typename M::_Item> operator()(int at_least, int total) const;
+};
+
+/* single subelement */
+template <class A> struct _One
+{
+    A item;
+    explicit _One(const A& a) :item(a)
+        {};
+    unsigned int size() const
+        {   return 1; }
+    const A* operator[](unsigned int) const
+        {   return &item; }
+};
+
+/* subelements of distinct types indexed at run time like the links of _Tie */
+template <class... A> struct _Items
+{
+    std::tuple<A...> item;
+    struct _At
+    {   const std::tuple<A...>* t; unsigned int i;
+        const _At* operator->() const
+            {   return this; }
+        template <unsigned int K> typename std::enable_if<(K < sizeof...(A)), int>::type _call(_Base* parser) const
+            {   return i == K? std::get<K>(*t)._parse(parser) : _call<K + 1>(parser); }
+        template <unsigned int K> typename std::enable_if<(K == sizeof...(A)), int>::type _call(_Base*) const
+            {   return eNone; }
+        template <unsigned int K> typename std::enable_if<(K < sizeof...(A)), bool>::type _pass(_Base* parser, int c) const
+            {   return i == K? std::get<K>(*t)._first(parser, c) : _pass<K + 1>(parser, c); }
+        template <unsigned int K> typename std::enable_if<(K == sizeof...(A)), bool>::type _pass(_Base*, int) const
+            {   return true; }
+        int _parse(_Base* parser) const
+            {   return _call<0>(parser); }
+        bool _first(_Base* parser, int c) const
+            {   return _pass<0>(parser, c); } };
+    explicit _Items(const A&... a) :item(a...)
+        {};
+    unsigned int size() const
+        {   return sizeof...(A); }
+    _At operator[](unsigned int i) const
+        {   _At at = { &item, i }; return at; }
+};
+
+class Token: public _Node<Token>
+{
+public:
+    static const int kind = _Static::kToken;
+    _Static::Set match;
+    std::string name;
+    Token(const bnf::Token& t) :match(_Static::_match(t)), name(_Static::_name(t))
+        {   null = false; first = _Op::_bytes(match); }
+    Token(const char c) :match(_Static::_match(bnf::Token(c))), name(1, c)
+        {   null = false; first = _Op::_bytes(match); }
+    Token(int fst, int lst) :match(_Static::_match(bnf::Token(fst, lst))), name(std::string(1, fst).append("-") += lst)
+        {   null = false; first = _Op::_bytes(match); }
+    Token(const char* s) :match(_Static::_match(bnf::Token(s))), name(s)
+        {   null = false; first = _Op::_bytes(match); }
+    int _parse(_Base* parser) const
+        {   return _Static::_token(*this, parser); }
+};
+
+template <unsigned int flg> struct _Ctrl: public _Node<_Ctrl<flg> >
+{
+    static const int kind = _Static::kCtrl;
+    _Ctrl() // Null and Skip only, other controls are not predictable
+        {   if (flg == eOk || flg == (eOk|eSkip)) this->first.reset(); }
+    int _parse(_Base*) const
+        {   return flg; }
+};
+typedef _Ctrl<eOk> Null;
+typedef _Ctrl<eOk|eRet> Return;
+typedef _Ctrl<e1st> AcceptFirst;
+typedef _Ctrl<eOk|eTry> Try;
+typedef _Ctrl<eOk|eTry|eCut> Cut;
+typedef _Ctrl<eOk|eSkip> Skip;
+typedef _Ctrl<eError|eSyntax> Catch;
+
+struct _Action: public _Node<_Action>
+{
+    static const int kind = _Static::kAction;
+    bool (*action)(const char* lexem, size_t len);
+    bool (*user_action)(const char* lexem, size_t len, void* user);
+    int _parse(_Base* parser) const
+        {   return _Static::_action(*this, parser); }
+};
+
+struct _Literal: public _Node<_Literal> // characters of Lexem("literal") compared at once
+{
+    static const int kind = _Static::kAnd;
+    std::string text;
+    bool cs;
+    int _parse(_Base* parser) const
+        {   return _Static::_literal(text, cs, parser); }
+};
+
+template <class... A> struct _And: public _Node<_And<A...> >
+{
+    static const int kind = _Static::kAnd;
+    _Items<A...> use;
+    explicit _And(const A&... a) :use(a...)
+        {   const _Expr* e[] = { &a... }; this->_seq(e, sizeof...(A)); }
+    int _parse(_Base* parser) const
+        {   return _Static::_and(*this, parser); }
+};
+
+template <class... A> struct _Or: public _Node<_Or<A...> >
+{
+    static const int kind = _Static::kOr;
+    _Items<A...> use;
+    explicit _Or(const A&... a) :use(a...)
+        {   const _Expr* e[] = { &a... }; this->_alt(e, sizeof...(A)); }
+    int _parse(_Base* parser) const
+        {   return _Static::_or(*this, parser); }
+};
+
+template <class A> struct _Cycle: public _Node<_Cycle<A> >
+{
+    static const int kind = _Static::kCycle;
+    _One<A> use;
+    unsigned int min, max;
+    int flag;
+    _Cycle(const A& a, int at_least, int total = maxRepeate, int limit = maxRepeate)
+        :use(a), min(at_least), max(total), flag(total < limit? eNone : eOver|eError)
+        {   this->first = a.first; this->null = !min || a.null; this->pred = !a.null; }
+    template <class B> static unsigned int _scan(const B&, _Base*, const char*&, int&, unsigned int)
+        {   return ~0u; }
+    static unsigned int _scan(const Token& t, _Base* parser, const char*& cc, int& eof, unsigned int max)
+        {   return _Static::_bulk(t.match, parser, cc, eof, max); }
+    unsigned int _bulk(_Base* parser, const char*& cc, int& eof) const // scan token repetition in lexem at once
+        {   return _scan(use.item, parser, cc, eof, max); }
+    int _parse(_Base* parser) const
+        {   return _Static::_cycle(*this, parser); }
+};
+template <class N> template <class M> inline _Cycle<typename M::_Item> _Node<N>::operator()(int at_least, int total) const
+    {   return _Cycle<typename M::_Item>(static_cast<const M&>(*this), at_least, total); }
+
+template <class A> struct _Lexem: public _Node<_Lexem<A> >
+{
+    static const int kind = _Static::kLexem;
+    _One<A> use;
+    bool memo;
+    std::string name;
+    _Lexem(const A& a, const char* nm) :use(a), memo(false), name(nm)
+        {   this->first = a.first; this->null = a.null; }
+    _Lexem& Memoize(bool on = true) // remember results by input position (packrat parsing)
+        {   memo = on; return *this; }
+    int _parse(_Base* parser) const
+        {   return _Static::_lexem(*this, parser); }
+};
+
+template <class A> struct _Rule: public _Node<_Rule<A> >
+{
+    static const int kind = _Static::kRule;
+    _One<A> use;
+    void* callback;
+    bool memo;
+    bool sync;
+    _Static::Set match;
+    std::string name;
+    _Rule(const A& a, const char* nm) :use(a), callback(0), memo(false), sync(false), name(nm)
+        {   this->first = a.first; this->null = a.null; }
+    _Rule& Memoize(bool on = true) // remember results by input position (packrat parsing)
+        {   memo = on; return *this; }
+    _Rule& Recover(const Token& t) // the same as Rule::Recover(), it is called before use in expressions
+        {   sync = true; match = t.match; this->first.set(); this->null = true; return *this; }
+    template <class U> _Rule& operator[](U (*callback)(std::vector<U>&))
+        {   this->callback = reinterpret_cast<void*>(callback); return *this; }
+    int _parse(_Base* parser) const
+        {   return _Static::_rule(*this, parser); }
+};
+
+struct _Ref;
+/* rule to be defined later by assignment of named element, it is kept by reference in expressions */
+class Forward: public _Node<Forward>
+{
+    const void* body;
+    int (*call)(const void* body, _Base* parser);
+    template <class N> static int _call(const void* body, _Base* parser)
+        {   return static_cast<const N*>(body)->_parse(parser); }
+    static int _none(const void*, _Base*)
+        {   return eError|eBadRule; }
+    Forward(const Forward&) = delete;
+public:
+    static const int kind = _Static::kRule;
+    typedef _Ref _Item;
+    Forward() :body(0), call(_none)
+        {};
+    template <class N> Forward& operator=(const _Node<N>& n) // n must live as long as the grammar
+        {   body = static_cast<const N*>(&n); call = _call<N>; return *this; }
+    template <class N> Forward& operator=(const _Node<N>&& n) = delete;
+    int _parse(_Base* parser) const
+        {   return call(body, parser); }
+};
+struct _Ref: public _Node<_Ref>
+{
+    static const int kind = _Static::kRule;
+    const Forward* ref;
+    _Ref(const Forward& f) :ref(&f)
+        {};
+    int _parse(_Base* parser) const
+        {   return ref->_parse(parser); }
+};
+
+/* operands of expressions: elements, strings as tokens and callbacks of the first kind */
+template <class N> inline typename N::_Item _item(const _Node<N>& n)
+    {   return static_cast<const N&>(n); }
+inline Token _item(const char* s)
+    {   return Token(s); }
+inline _Action _item(bool (*f)(const char*, size_t))
+    {   _Action a; a.action = f; a.user_action = 0; return a; }
+inline _Action _item(bool (*f)(const char*, size_t, void*))
+    {   _Action a; a.action = 0; a.user_action = f; return a; }
+
+template <unsigned int... I> struct _Idx
+{};
+template <unsigned int K, unsigned int... I> struct _Seq: _Seq<K - 1, K - 1, I...>
+{};
+template <unsigned int... I> struct _Seq<0, I...>
+{   typedef _Idx<I...> type; };
+template <class R, class T, class B, unsigned int... I> inline R _append(const T& t, const B& b, _Idx<I...>)
+    {   return R(std::get<I>(t)..., b); }
+
+/* sequences and alternatives are flat like _And and _Or of grammar graph */
+template <class A, class B> inline _And<A, B> _and(const A& a, const B& b)
+    {   return _And<A, B>(a, b); }
+template <class... A, class B> inline _And<A..., B> _and(const _And<A...>& a, const B& b)
+    {   return _append<_And<A..., B> >(a.use.item, b, typename _Seq<sizeof...(A)>::type()); }
+template <class A, class B> inline _Or<A, B> _or(const A& a, const B& b)
+    {   return _Or<A, B>(a, b); }
+template <class... A, class B> inline _Or<A..., B> _or(const _Or<A...>& a, const B& b)
+    {   return _append<_Or<A..., B> >(a.use.item, b, typename _Seq<sizeof...(A)>::type()); }
+
+template <class A, class B> struct _Either
+{   enum { value = std::is_base_of<_Expr, A>::value || std::is_base_of<_Expr, B>::value }; };
+template <class A, class B, class = typename std::enable_if<_Either<A, B>::value>::type>
+inline auto operator+(const A& a, const B& b) -> decltype(_and(_item(a), _item(b)))
+    {   return _and(_item(a), _item(b)); }
+template <class A, class B, class = typename std::enable_if<_Either<A, B>::value>::type>
+inline auto operator|(const A& a, const B& b) -> decltype(_or(_item(a), _item(b)))
+    {   return _or(_item(a), _item(b)); }
+template <class N> inline _Cycle<typename N::_Item> operator*(const _Node<N>& n)
+    {   return _Cycle<typename N::_Item>(_item(n), 0); }
+template <class N> inline _Cycle<typename N::_Item> operator!(const _Node<N>& n)
+    {   return _Cycle<typename N::_Item>(_item(n), 0, 1); }
+template <class N> inline _Cycle<typename N::_Item> operator*(int at_least, const _Node<N>& n)
+    {   return _Cycle<typename N::_Item>(_item(n), at_least); }
+template <class N> inline _Lexem<typename N::_Item> Lexem(const _Node<N>& n, const char* name = "")
+    {   return _Lexem<typename N::_Item>(_item(n), name); }
+inline _Lexem<_Literal> Lexem(const char* literal, bool cs = false)
+    {   _Literal l; l.text = literal; l.cs = cs;
+        if (*literal) {
+            l.null = false; l.first.reset(); l.first.set((unsigned char)*literal);
+            if (cs && (unsigned char)((*literal | 0x20) - 'a') < 26) l.first.set(*literal ^ 0x20); }
+        return _Lexem<_Literal>(l, literal); }
+template <class N> inline _Rule<typename N::_Item> Rule(const _Node<N>& n, const char* name = "")
+    {   return _Rule<typename N::_Item>(_item(n), name); }
+template <class A> inline _Lexem<A> Lexem(const _Lexem<A>& n, const char* name = "") // the same lexem
+    {   _Lexem<A> l(n); if (*name) l.name = name; return l; }
+template <class A> inline _Rule<A> Rule(const _Rule<A>& n, const char* name = "") // the same rule
+    {   _Rule<A> r(n); if (*name) r.name = name; return r; }
+
+/* repetitions of rules, lexems and tokens, other elements are converted like for grammar graph */
+template <class N> inline _Cycle<_Rule<typename N::_Item> > Repeat(int at_least, const _Node<N>& n,
+    int total = maxLexemLength, int limit = maxRepeate)
+    {   return _Cycle<_Rule<typename N::_Item> >(Rule(n), at_least, total, limit); }
+template <class A> inline _Cycle<_Rule<A> > Repeat(int at_least, const _Rule<A>& n,
+    int total = maxLexemLength, int limit = maxRepeate)
+    {   return _Cycle<_Rule<A> >(n, at_least, total, limit); }
+inline _Cycle<_Ref> Repeat(int at_least, const Forward& n, int total = maxLexemLength, int limit = maxRepeate)
+    {   return _Cycle<_Ref>(n, at_least, total, limit); }
+template <class N> inline _Cycle<_Lexem<typename N::_Item> > Iterate(int at_least, const _Node<N>& n,
+    int total = maxLexemLength, int limit = maxLexemLength)
+    {   return _Cycle<_Lexem<typename N::_Item> >(Lexem(n), at_least, total, limit); }
+template <class A> inline _Cycle<_Lexem<A> > Iterate(int at_least, const _Lexem<A>& n,
+    int total = maxLexemLength, int limit = maxLexemLength)
+    {   return _Cycle<_Lexem<A> >(n, at_least, total, limit); }
+inline _Cycle<Token> Series(int at_least, const Token& n, int total = maxLexemLength, int limit = maxCharNum)
+    {   return _Cycle<Token>(n, at_least, total, limit); }
+
+/* root of grammar to be passed to Analyze functions instead of Rule */
+template <class A> class _Root: public _Tie
+{
+    A body;
+protected:
+    virtual int _parse(_Base* parser) const throw()
+        {   return body._parse(parser); }
+public:
+    explicit _Root(const A& a) :_Tie("root"), body(a)
+        {};
+    _Root(const _Root& r) :_Tie(r.name), body(r.body)
+        {};
+};
+template <class N> inline _Root<typename N::_Item> Root(const _Node<N>& n)
+    {   return _Root<typename N::_Item>(_item(n)); }
+
+}; // bnf::ct::
+#endif
+
 
 }; // bnf::
 #endif // BNFLITE_H
@@ -71,8 +71,11 @@ private:
         }
     };
 
-    static Stack<XprsTree*> rootNode;
-    static int lastNumber;
+    struct State // per-call state of Evaluate, so one gramma serves several threads
+    {   Stack<XprsTree*> rootNode;
+        int lastNumber;
+        State(): lastNumber(0) {};
+    };
 
 
     Rule PrimaryXprs;
@@ -93,26 +96,26 @@ private:
     Rule MainXprs; 
 
     /* 1st kind of callback */
-    static bool getHexNumber(const char* lexem, size_t len);
-    static bool getNumber(const char* lexem, size_t len);
+    static bool getHexNumber(const char* lexem, size_t len, void* user);
+    static bool getNumber(const char* lexem, size_t len, void* user);
     static bool dbgPrint(const char* lexem, size_t len);
     static bool printMsg(const char* lexem, size_t len);
     static bool syntaxError(const char* lexem, size_t len);
-    static bool numberAction(const char* lexem, size_t len);
-    static bool buildBinaryAction(const char* lexem, size_t len);
-    static bool buildUnaryAction(const char* lexem, size_t len);
-    static bool unaryAction(const char* lexem, size_t len);
+    static bool numberAction(const char* lexem, size_t len, void* user);
+    static bool buildBinaryAction(const char* lexem, size_t len, void* user);
+    static bool buildUnaryAction(const char* lexem, size_t len, void* user);
+    static bool unaryAction(const char* lexem, size_t len, void* user);
     static bool postfixAction(const char* lexem, size_t len);
-    static bool binaryAction(const char* lexem, size_t len);
-    static bool ifAction(const char* lexem, size_t len);
-    static bool thenAction(const char* lexem, size_t len);
-    static bool elseAction(const char* lexem, size_t len);
+    static bool binaryAction(const char* lexem, size_t len, void* user);
+    static bool ifAction(const char* lexem, size_t len, void* user);
+    static bool thenAction(const char* lexem, size_t len, void* user);
+    static bool elseAction(const char* lexem, size_t len, void* user);
 
 
     static int GetOperationPriority(unsigned int op);
     static int Calcualte(XprsTree& node);
 
-    bool ParseExpression(const char *expression);
+    bool ParseExpression(const char *expression, State& state);
     void GrammaInit();
 
 public:
@@ -121,13 +124,12 @@ public:
     ~C_Xprs(){ MainXprs = Null(); UnaryXprs = Null(); };
 };
 
-C_Xprs::Stack<XprsTree*> C_Xprs::rootNode;
-int C_Xprs::lastNumber;
 
 
 
-bool C_Xprs::getHexNumber(const char* lexem, size_t len)
-{   
+bool C_Xprs::getHexNumber(const char* lexem, size_t len, void* user)
+{
+    int& lastNumber = static_cast<State*>(user)->lastNumber;
     int i = 0;
     lastNumber = 0;
     if ( len > 1 && lexem[0] == '0' && (lexem[1] == 'X' || lexem[1] == 'x')) 
@@ -144,8 +146,9 @@ bool C_Xprs::getHexNumber(const char* lexem, size_t len)
     return true;
 }
 
-bool C_Xprs::getNumber(const char* lexem, size_t len)
-{   
+bool C_Xprs::getNumber(const char* lexem, size_t len, void* user)
+{
+    int& lastNumber = static_cast<State*>(user)->lastNumber;
     lastNumber = 0;
     for (int i = 0; i < len && lexem[i] >= '0' && lexem[i] <= '9'; i++) {
         lastNumber = 10 * lastNumber + (lexem[i] - '0');    
@@ -175,8 +178,10 @@ bool C_Xprs::syntaxError(const char* lexem, size_t len)
 
 
 
-bool C_Xprs::numberAction(const char* lexem, size_t len)
+bool C_Xprs::numberAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
+    int& lastNumber = static_cast<State*>(user)->lastNumber;
     XprsTree* node = new XprsTree();
     node->val =  lastNumber;
     rootNode.push(node);
@@ -184,8 +189,9 @@ bool C_Xprs::numberAction(const char* lexem, size_t len)
 }
 
 
-bool C_Xprs::buildBinaryAction(const char* lexem, size_t len)
+bool C_Xprs::buildBinaryAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
    int getopprio(unsigned int op);
     if (rootNode.size() >= 2)
     {
@@ -206,8 +212,9 @@ bool C_Xprs::buildBinaryAction(const char* lexem, size_t len)
 }
 
 
-bool C_Xprs::buildUnaryAction(const char* lexem, size_t len)
+bool C_Xprs::buildUnaryAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     if (rootNode.size() >= 2)
     {
         XprsTree* child = rootNode.getpop();
@@ -218,8 +225,9 @@ bool C_Xprs::buildUnaryAction(const char* lexem, size_t len)
 }
 
 
-bool C_Xprs::unaryAction(const char* lexem, size_t len)
+bool C_Xprs::unaryAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     if (len > 1 && ((lexem[0] == '+' && lexem[1] == '+') || (lexem[0] == '-' && lexem[1] == '-'))) {
         return false; // not supported operations
     }
@@ -238,8 +246,9 @@ bool C_Xprs::postfixAction(const char* lexem, size_t len)
 }
 
 
-bool C_Xprs::binaryAction(const char* lexem, size_t len)
+bool C_Xprs::binaryAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     XprsTree* node = new XprsTree();
     node->right = rootNode.getpop();
     rootNode.push(node);
@@ -250,8 +259,9 @@ bool C_Xprs::binaryAction(const char* lexem, size_t len)
     return true;
 }
 
-bool C_Xprs::ifAction(const char* lexem, size_t len)
+bool C_Xprs::ifAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     XprsTree* node = new XprsTree();
     node->right = rootNode.getpop();
     rootNode.push(node);
@@ -262,8 +272,9 @@ bool C_Xprs::ifAction(const char* lexem, size_t len)
 }
 
 
-bool C_Xprs::thenAction(const char* lexem, size_t len)
+bool C_Xprs::thenAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     if (rootNode.size() > 0) {
         XprsTree* node = rootNode.getpop();
         rootNode.top()->right = node;
@@ -271,8 +282,9 @@ bool C_Xprs::thenAction(const char* lexem, size_t len)
     return true;
 }
 
-bool C_Xprs::elseAction(const char* lexem, size_t len)
+bool C_Xprs::elseAction(const char* lexem, size_t len, void* user)
 {
+    Stack<XprsTree*>& rootNode = static_cast<State*>(user)->rootNode;
     if (rootNode.size() > 0) {
         XprsTree* node = rootNode.getpop();
         rootNode.getpop()->left = node;
@@ -461,10 +473,11 @@ int catch_syntax_error(const char* ptr)
 }
 
 
-bool C_Xprs::ParseExpression(const char *expression)
+bool C_Xprs::ParseExpression(const char *expression, State& state)
 {
     const char *last = 0;
-    int tst = Analyze(MainXprs, expression, &last);
+    Options opt; opt.user = &state;
+    int tst = Analyze(MainXprs, expression, &last, 0, &opt);
     if (tst < 0) {
         std::cout << " Analize: expression not OK, " << "Err = {" << std::hex
             << (tst&eOk?"eOk":"eErr")
@@ -486,12 +499,13 @@ bool C_Xprs::ParseExpression(const char *expression)
 bool C_Xprs::Evaluate(const char *expression, int& result)
 {
     bool ok = 0;
-    if (ParseExpression(expression) && rootNode.size() == 1 ) {
-        result = Calcualte(*rootNode.top());
+    State state;
+    if (ParseExpression(expression, state) && state.rootNode.size() == 1 ) {
+        result = Calcualte(*state.rootNode.top());
         ok = 1;
     } 
-    while(!rootNode.empty()) {
-       XprsTree* node = rootNode.getpop();
+    while(!state.rootNode.empty()) {
+       XprsTree* node = state.rootNode.getpop();
        delete node;
     }
     return ok;
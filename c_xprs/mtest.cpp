@@ -0,0 +1,67 @@
+/*************************************************************************\
+*   Multithreaded test of C expression parser (based on BNFlite)          *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+
+/* One grammar is shared by all threads, build it with ThreadSanitizer:  */
+/*     g++ -std=c++11 -g -fsanitize=thread -I.. mtest.cpp -o mtest       */
+
+#include <ostream>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include "c_xprs.h"
+
+
+C_Xprs gramma;
+
+#define C_XPRS(a) { #a, (a) }
+
+static const struct { const char* expression; int result; } tests[] = {
+    C_XPRS(0XFFFf),
+    C_XPRS(!(0)),
+    C_XPRS(2+0x11),
+    C_XPRS((2&&1)==!(!2||!1)),
+    C_XPRS((3&0xE)==~(~3|~0Xe)),
+    C_XPRS(1+(0? 2: 3)-1),
+    C_XPRS(2+3-0x4+5),
+    C_XPRS(((5+1)*4)+1),
+    C_XPRS(1 + (0&&3) + (3|4) * (1-1<0?5:6)-4<<8-7)
+};
+
+static std::atomic<int> errors(0);
+
+static void worker(int id)
+{
+    for (int i = 0; i < 200; i++) {
+        const size_t k = (id + i) % (sizeof(tests)/sizeof(tests[0]));
+        std::string expression(tests[k].expression); // own copy of the text for each call
+        int value = 0;
+        if (!gramma.Evaluate(expression.c_str(), value) || value != tests[k].result) {
+            errors++; }
+    }
+}
+
+int main()
+{
+    std::thread threads[32];
+    for (int i = 0; i < 32; i++)
+        threads[i] = std::thread(worker, i);
+    for (int i = 0; i < 32; i++)
+        threads[i].join();
+    std::cout << (errors? "Not Passed: ": "Passed: ") << errors << " errors in 32 threads\n";
+    return errors != 0;
+}
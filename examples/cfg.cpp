@@ -19,7 +19,7 @@
 
 #include <vector>
 #include <iostream>
-#include "bnflite.h"
+#include "cfg.h"
 
 using namespace bnf;
 using namespace std;
@@ -43,12 +43,6 @@ vector <struct client> Cfg;  // client configuration container
 string tmpstr;
 
 
-static bool printMsg(const char* lexem, size_t len)
-{   // debug function
-    printf("Debug: %.*s;\n", len, lexem);
-    return true; // should retuirn true to continue parsing
-}
-
 static bool addkey(const char* lexem, size_t len)
 {   
     Cfg.resize(Cfg.size() + 1);
@@ -77,28 +71,8 @@ static bool addlimit(const char* lexem, size_t len)
 
 int main()
 {
-    Token value(1,255); value.Remove("\""); // assume the value can contain any character
-
-    Lexem client("client"); // literals
-    Lexem key("key");
-    Lexem type("type");
-    Lexem alert("alert");
-    Lexem limit("limit");
-    Lexem mail("mail");
-
-    Lexem quotedvalue = "\"" + *value + "\"";
-    Lexem _client = Token("<") + Token("/") + client  +">";
-    Lexem _end = Token("/") +">";
-
-    Rule xclient = Token("<") + client  + key  + "=" + quotedvalue + addkey
-                                        + mail + "=" + quotedvalue + addmail + ">";
-    Rule xalert = Token("<") + alert  + type + "=" + quotedvalue + addtype
-                                                + limit + "=" +  quotedvalue + addlimit + _end;
-
-    Rule xclient1 = xclient + printMsg;
-    Rule xalert1 = xalert + printMsg;
-   
-    Rule root = *(xclient  + *(xalert) + _client);
+    Rule root;
+    CfgGramma(root, addkey, addmail, addtype, addlimit);
     
     const char* tail = 0;
     int tst = Analyze(root, xml, &tail);
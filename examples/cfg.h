@@ -0,0 +1,56 @@
+/*************************************************************************\
+*   Grammar of restricted custom xml configuration (based on BNFlite)     *
+*   Copyright (c) 2017 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+#ifndef CFG_H
+#define CFG_H
+
+#include <limits.h>
+#include "bnflite.h"
+
+/* shared by cfg.cpp and benchmark, callbacks get quoted values of attributes */
+inline bool CfgValue(const char*, size_t)
+{
+    return true;
+}
+
+inline void CfgGramma(bnf::Rule& root,
+    bool (*addkey)(const char* lexem, size_t len) = CfgValue, bool (*addmail)(const char* lexem, size_t len) = CfgValue,
+    bool (*addtype)(const char* lexem, size_t len) = CfgValue, bool (*addlimit)(const char* lexem, size_t len) = CfgValue)
+{
+    using namespace bnf;
+    Token value(1,255); value.Remove("\""); // assume the value can contain any character
+
+    Lexem client("client"); // literals
+    Lexem key("key");
+    Lexem type("type");
+    Lexem alert("alert");
+    Lexem limit("limit");
+    Lexem mail("mail");
+
+    Lexem quotedvalue = "\"" + *value + "\"";
+    Lexem _client = Token("<") + Token("/") + client  +">";
+    Lexem _end = Token("/") +">";
+
+    Rule xclient = Token("<") + client  + key  + "=" + quotedvalue + addkey
+                                        + mail + "=" + quotedvalue + addmail + ">";
+    Rule xalert = Token("<") + alert  + type + "=" + quotedvalue + addtype
+                                                + limit + "=" +  quotedvalue + addlimit + _end;
+
+    root = Repeat(0, xclient  + *(xalert) + _client, INT_MAX); // clients are not limited by maxRepeate
+}
+
+#endif // CFG_H
@@ -17,7 +17,7 @@
 \*************************************************************************/
 #include "stdio.h"
 #include "stdlib.h"
-#include "bnflite.h"
+#include "cmd.h"
 
 using namespace bnf;
 
@@ -30,30 +30,8 @@ static bool printFilter(const char* lexem, size_t len)
 
 int main(int argc, char* argv[])
 {
-/*
-    BNF description of the ffmpeg filtergraph syntax 
-    from https://ffmpeg.org/ffmpeg-filters.html (simplified for this example)
-        NAME             ::= sequence of alphanumeric characters and '_'
-        LINKLABEL        ::= "[" NAME "]"
-        LINKLABELS       ::= LINKLABEL [LINKLABELS]
-        FILTER_ARGUMENTS ::= sequence of chars (possibly quoted)
-        FILTER           ::= [LINKLABELS] NAME ["=" FILTER_ARGUMENTS] [LINKLABELS]
-        FILTERCHAIN      ::= FILTER [,FILTERCHAIN]
-*/
-	Token Alphanumeric('_');    // start declare one element of "sequence of alphanumeric characters"
-	Alphanumeric.Add('0', '9'); // appended numeric part
-	Alphanumeric.Add('a', 'z'); // appended alphabetic lowercase part
-	Alphanumeric.Add('A', 'Z'); // appended alphabetic capital part
-    Lexem NAME = Series(1, Alphanumeric); // declare "sequence of alphanumeric characters"
-    Lexem LINKLABEL = "[" + NAME + "]";
-    Lexem LINKLABELS1  =  Iterate(1, LINKLABEL); // declare as described
-    Lexem LINKLABELS0  =  Iterate(0, LINKLABEL); // declare as needed to use
-    Token  SequenceOfChars(' ' + 1, 0x7F - 1); // declare one element of "sequence of chars"
-    SequenceOfChars.Remove("=,");  // exclude used(reserved) chars
-    Lexem FILTER_ARGUMENTS = Series(1, SequenceOfChars); // declare "sequence of chars"
-    Lexem FILTER = LINKLABELS0 + NAME + Iterate(0, "=" + FILTER_ARGUMENTS) + LINKLABELS0;
-    Rule Filter = FILTER + printFilter;  // form found filter
-    Rule FILTERCHAIN = Filter + Repeat(0, "," + Filter); // declare several filters
+    Rule FILTERCHAIN; // declare several filters
+    CmdGramma(FILTERCHAIN, printFilter);
 
     const char* test; int stat;
     const char* pstr = 0;
@@ -0,0 +1,58 @@
+/*************************************************************************\
+*   Grammar of simple command line parameters (based on BNFlite)          *
+*   Copyright (c) 2017 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+#ifndef CMD_H
+#define CMD_H
+
+#include "bnflite.h"
+
+/* shared by cmd.cpp and benchmark, filter is called for each found filter */
+inline bool CmdFilter(const char*, size_t)
+{
+    return true;
+}
+
+inline void CmdGramma(bnf::Rule& root, bool (*filter)(const char* lexem, size_t len) = CmdFilter)
+{
+    using namespace bnf;
+/*
+    BNF description of the ffmpeg filtergraph syntax 
+    from https://ffmpeg.org/ffmpeg-filters.html (simplified for this example)
+        NAME             ::= sequence of alphanumeric characters and '_'
+        LINKLABEL        ::= "[" NAME "]"
+        LINKLABELS       ::= LINKLABEL [LINKLABELS]
+        FILTER_ARGUMENTS ::= sequence of chars (possibly quoted)
+        FILTER           ::= [LINKLABELS] NAME ["=" FILTER_ARGUMENTS] [LINKLABELS]
+        FILTERCHAIN      ::= FILTER [,FILTERCHAIN]
+*/
+    Token Alphanumeric('_');    // start declare one element of "sequence of alphanumeric characters"
+    Alphanumeric.Add('0', '9'); // appended numeric part
+    Alphanumeric.Add('a', 'z'); // appended alphabetic lowercase part
+    Alphanumeric.Add('A', 'Z'); // appended alphabetic capital part
+    Lexem NAME = Series(1, Alphanumeric); // declare "sequence of alphanumeric characters"
+    Lexem LINKLABEL = "[" + NAME + "]";
+    Lexem LINKLABELS1  =  Iterate(1, LINKLABEL); // declare as described
+    Lexem LINKLABELS0  =  Iterate(0, LINKLABEL); // declare as needed to use
+    Token  SequenceOfChars(' ' + 1, 0x7F - 1); // declare one element of "sequence of chars"
+    SequenceOfChars.Remove("=,");  // exclude used(reserved) chars
+    Lexem FILTER_ARGUMENTS = Series(1, SequenceOfChars); // declare "sequence of chars"
+    Lexem FILTER = LINKLABELS0 + NAME + Iterate(0, "=" + FILTER_ARGUMENTS) + LINKLABELS0;
+    Rule Filter = FILTER + filter;  // form found filter
+    root = Filter + Repeat(0, "," + Filter); // declare several filters
+}
+
+#endif // CMD_H
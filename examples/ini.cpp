@@ -19,7 +19,7 @@
 
 #include <vector>
 #include <iostream>
-#include "bnflite.h"
+#include "ini.h"
 
 using namespace bnf;
 using namespace std;
@@ -99,40 +99,11 @@ static void Bind(Rule& section, Rule& entry)
     Bind(entry, DoValue);
 }
 
-// example of custom pre-parser
-static const char* ini_zero_parse(const char* ptr)
-{   // skip ini file comments
-    if (*ptr ==';' ||  *ptr =='#')
-        while (*ptr != 0)
-            if( *ptr++ == '\n')
-                break;
-    return ptr;
-}
-
 
 int main()
 {
-    Token space(" \t");  // space and tab are grammar part in ini files
-    Token delimiter(" \t\n\r");     // consider new lines as grammar part too
-    Token name("_.,:(){}-#@&*|");  // start declare with special symbols
-    name.Add('0', '9'); // appended numeric part
-    name.Add('a', 'z'); // appended alphabetic lowercase part
-    name.Add('A', 'Z'); // appended alphabetic capital part
-    Token value(1,255); value.Remove("\n");
-
-    Lexem Name = 1*name;
-    Lexem Value = *value;
-    Lexem Equal = *space + "=" + *space;
-    Lexem Left  = *space + "[" + *space;        // bracket
-    Lexem Right  = *space + "]" + *space;
-    Lexem Delimiter  = *delimiter;
-
-    Rule Item = Name + Equal + Value + "\n";
-    Rule Section = Left + Name + Right + "\n";
-    Rule Inidata = Delimiter + *(Section + Delimiter + *(Item + Delimiter)) ;
-
-
-    Bind(Section, Item);
+    Rule Inidata;
+    IniGramma(Inidata, Bind);
 
     Gen gen; // this is Interface object
 
@@ -0,0 +1,64 @@
+/*************************************************************************\
+*   Grammar of configuration ini-files (based on BNFlite)                 *
+*   Copyright (c) 2017 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.    *
+*                                                                         *
+*   This code is free software: you can redistribute it and/or modify it  *
+*   under the terms of the GNU Lesser General Public License as published *
+*   by the Free Software Foundation, either version 3 of the License,     *
+*   or (at your option) any later version.                                *
+*                                                                         *
+*   This program is distributed in the hope that it will be useful,       *
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+*   GNU General Public License for more details.                          *
+*                                                                         *
+*   You should have received a copy of the GNU General Public License     *
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+\*************************************************************************/
+#ifndef INI_H
+#define INI_H
+
+#include <limits.h>
+#include "bnflite.h"
+
+/* shared by ini.cpp and benchmark, bind can set callbacks of section and entry rules */
+
+// example of custom pre-parser
+inline const char* ini_zero_parse(const char* ptr)
+{   // skip ini file comments
+    if (*ptr ==';' ||  *ptr =='#')
+        while (*ptr != 0)
+            if( *ptr++ == '\n')
+                break;
+    return ptr;
+}
+
+inline void IniGramma(bnf::Rule& root, void (*bind)(bnf::Rule& section, bnf::Rule& entry) = 0)
+{
+    using namespace bnf;
+    Token space(" \t");  // space and tab are grammar part in ini files
+    Token delimiter(" \t\n\r");     // consider new lines as grammar part too
+    Token name("_.,:(){}-#@&*|");  // start declare with special symbols
+    name.Add('0', '9'); // appended numeric part
+    name.Add('a', 'z'); // appended alphabetic lowercase part
+    name.Add('A', 'Z'); // appended alphabetic capital part
+    Token value(1,255); value.Remove("\n");
+
+    Lexem Name = 1*name;
+    Lexem Value = *value;
+    Lexem Equal = *space + "=" + *space;
+    Lexem Left  = *space + "[" + *space;        // bracket
+    Lexem Right  = *space + "]" + *space;
+    Lexem Delimiter  = *delimiter;
+
+    Rule Item = Name + Equal + Value + "\n";
+    Rule Section = Left + Name + Right + "\n";
+    // Cut() commits each entry and section: their results are released after their callbacks,
+    // so a callback bound to root would get only the last section instead of all of them;
+    // sections are not limited by maxRepeate
+    root = Delimiter + Repeat(0, Section + Delimiter + *(Item + Delimiter + Cut()) + Cut(), INT_MAX);
+
+    if (bind) bind(Section, Item);
+}
+
+#endif // INI_H
@@ -35,12 +35,12 @@ typedef Interface< std::list<byte_code> > Gen;
 
 Gen DoBracket(std::vector<Gen>& res)
 {
-    return *res[0].text == '('? res[1] : res[0]; /* pass result without brackets */
+    return *res[0].text == '('? std::move(res[1]) : std::move(res[0]); /* pass result without brackets */
 }
 
 Gen DoString(std::vector<Gen>& res)
 {
-    return res[1];
+    return std::move(res[1]);
 }
 
 
@@ -64,18 +64,18 @@ Gen DoNumber(std::vector<Gen>& res)
 Gen DoUnary(std::vector<Gen>& res)
 {   /* pass result of unary operation ( just only '-' ) */
     if (*res[0].text == '-') {
-        return Gen(GenUnaryOp('-', res[1].data), res);
+        return Gen(GenUnaryOp('-', std::move(res[1].data)), res);
     }
-    return res[0];
+    return std::move(res[0]);
 }
 
 Gen DoBinary(std::vector<Gen>& res)
 {   /* pass result of binary operation (shared for several rules) */
-    std::list<byte_code> left = res[0].data;
+    std::list<byte_code> left = std::move(res[0].data);
     for (unsigned int i = 1; i <  ((res.size() - 1) | 1); i += 2) {
-        left = GenBinaryOp(left, *res[i].text, res[i + 1].data);
+        left = GenBinaryOp(std::move(left), *res[i].text, std::move(res[i + 1].data));
     }
-    return Gen(left, res);
+    return Gen(std::move(left), res);
 }
 
 Gen DoFunction(std::vector<Gen>& res)
@@ -86,13 +86,13 @@ Gen DoFunction(std::vector<Gen>& res)
         if( *res[i].text == '(' ||  *res[i].text == ',' ||  *res[i].text == ')' ) {
             continue;
         }
-        args.push_back(res[i].data);
+        args.push_back(std::move(res[i].data));
     }
-    return Gen(GenCallOp(std::string(res[0].text, res[0].length), args), res);
+    return Gen(GenCallOp(std::string(res[0].text, res[0].length), std::move(args)), res);
 }
 
 
-std::list<byte_code> bnflite_byte_code(std::string expr)
+static void FormulaGramma(Rule& root)
 {
     Token digit1_9('1', '9');
     Token DIGIT("0123456789");
@@ -111,7 +111,7 @@ std::list<byte_code> bnflite_byte_code(std::string expr)
     Lexem identifier = az_  + *(az01_);
     Lexem quotedstring = "\"" + *all + "\"";
 
-    Rule expression;
+    Rule& expression = root;    // the top rule is kept by Grammar
     Rule unary;
 
     Rule function = identifier + "(" + !(expression + *("," + expression)) +  ")";
@@ -135,18 +135,21 @@ std::list<byte_code> bnflite_byte_code(std::string expr)
     Bind(primary, DoBinary);
     Bind(expression, DoBinary);
     Bind(function, DoFunction);
+}
+
 
+std::list<byte_code> bnflite_byte_code(std::string expr)
+{
+    static Grammar gramma(FormulaGramma); // built once, recursive rules are released with it
     const char* tail = 0;
     Gen result;
 
-    int tst = Analyze(expression, expr.c_str(), &tail, result);
+    int tst = Analyze(gramma, expr.c_str(), &tail, result);
     if (tst > 0)
         std::cout << result.data.size() << " byte-codes in: " << expr << std::endl;
     else
         std::cout << "Parsing errors detected, status = " << std::hex << tst << std::endl
          << "stopped at: " << tail << std::endl;
 
-    expression = Null();  // disjoin Rule recursion to safe Rules removal
-    unary = Null();
     return result.data;
 }
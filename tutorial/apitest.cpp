@@ -0,0 +1,64 @@
+/****************************************************************************\
+*   Unit test of Analyze API function set (based on BNFlite)                 *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.       *
+*                                                                            *
+*   Permission to use, copy, modify, and distribute this software for any    *
+*   purpose with or without fee is hereby granted, provided that the above   *
+*   copyright notice and this permission notice appear in all copies.        *
+*                                                                            *
+*   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES *
+*   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF         *
+*   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR  *
+*   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES   *
+*   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN    *
+*   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF  *
+*   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.           *
+\****************************************************************************/
+
+/* Build: g++ -I.. apitest.cpp -o apitest (also with -std=c++98)             */
+/* The test is mostly compiled: calls of the user's code must not be        */
+/* ambiguous, e.g. null pstop is not taken for end of text                  */
+
+#include "bnflite.h"
+#include <stdio.h>
+
+using namespace bnf;
+
+static int errors = 0;
+
+static void Check(const char* call, int stat, int expected)
+{
+    if (stat == expected) return;
+    errors++;
+    printf("Not Passed: %s returns %x instead of %x\n", call, stat, expected);
+}
+
+#define CHECK(call, expected) Check(#call, call, expected)
+
+int main()
+{
+    Token digit('0', '9');
+    Lexem num = 1*digit;
+    Rule sum = num + *("+" + num);
+    const char* text = "1 + 22 + 333";
+    const char* stop = 0;
+    Interface<> u;
+
+    CHECK(Analyze(sum, text), eOk|eEof);
+    CHECK(Analyze(sum, text, 0), eOk|eEof);
+    CHECK(Analyze(sum, text, NULL), eOk|eEof);
+    CHECK(Analyze(sum, text, 0, u), eOk|eEof);
+    CHECK(Analyze(sum, text, NULL, u), eOk|eEof);
+    CHECK(Analyze(sum, text, &stop, u), eOk|eEof);
+#if __cplusplus > 199711L
+    CHECK(Analyze(sum, text, nullptr), eOk|eEof);
+    CHECK(Analyze(sum, text, nullptr, u), eOk|eEof);
+#endif
+    CHECK(AnalyzeRange(sum, text, text + 6), eOk|eEof);
+    CHECK(AnalyzeRange(sum, text, text + 6, 0, u), eOk|eEof);
+    CHECK(AnalyzeRange(sum, text, text + 6, &stop), eOk|eEof);
+    if (stop != text + 6) { errors++; printf("Not Passed: stop of AnalyzeRange\n"); }
+
+    printf("%s: %d errors\n", errors? "Not Passed": "Passed", errors);
+    return errors != 0;
+}
@@ -78,10 +78,9 @@ public:
             string str0(" ");
             if (curitr != this->get()->end()) _dumptree(*curitr, str0, out);  }
     static Repo ParseJSON(const char* text, int* status, const char** pstop = 0)
-        {   Rule root, element;
-            JSONGramma(root, element);
+        {   static Grammar gramma(JSONGramma); // built once per process
             gramma_callback(eStart, 0, 0);
-            int tst = Analyze(root, text, pstop);
+            int tst = Analyze(gramma, text, pstop);
 	        if (status) *status = tst;
 	        return tst >= 0 ? Repo(gramma_callback(eGetRepo, 0, 0)) : Repo();   }
 
@@ -170,8 +169,9 @@ protected:
         }
         return 0;
     }
-    static void JSONGramma(Rule& root, Rule& element)
+    static void JSONGramma(Rule& root)
     {
+        Rule element;
 	    Lexem ws = *Token("\x20\x0A\x0D\x09"); // will be not used due to standard pre-parsing in this implementation
 	    Lexem sign =  !Token("+-");
 	    Token onenine('1', '9');
@@ -184,7 +184,7 @@ protected:
 	    Lexem number = integer + fraction + exponent;
 
 	    Lexem hex =  digit | Token('A', 'F') | Token('a', 'f');
-	    Lexem escape = Token("\"\\/bfnrt") | ("u" + 4 * hex);
+	    Lexem escape = Token("\"\\/bfnrt") | ("u" + hex(4, 4));
 
         Token any(0x20, 255);
         any.Remove("\"\\");
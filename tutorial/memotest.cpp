@@ -0,0 +1,109 @@
+/****************************************************************************\
+*   Unit test of memoization of rules and lexems (based on BNFlite)          *
+*   Copyright (c) 2018 by Alexander A. Semjonov.  ALL RIGHTS RESERVED.       *
+*                                                                            *
+*   Permission to use, copy, modify, and distribute this software for any    *
+*   purpose with or without fee is hereby granted, provided that the above   *
+*   copyright notice and this permission notice appear in all copies.        *
+*                                                                            *
+*   THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES *
+*   WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF         *
+*   MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR  *
+*   ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES   *
+*   WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN    *
+*   ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF  *
+*   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.           *
+\****************************************************************************/
+
+/* Build: g++ -I.. memotest.cpp -o memotest                                 */
+/* Status, stop position and result of each text must not depend on        */
+/* memoization (Memoize() or Options::memo) and on compiled Program         */
+
+#include "bnflite.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace bnf;
+
+typedef Interface<int> Gen;
+
+static Gen DoSum(std::vector<Gen>& res)
+{
+    int sum = 0;
+    for (size_t i = 0; i < res.size(); i++) sum += res[i].data;
+    return Gen(sum + 1, res);
+}
+
+static int errors = 0;
+
+static void Check(const char* test, const char* text, int stat, const char* stop, int data,
+                  int stat2, const char* stop2, int data2)
+{
+    if (stat == stat2 && stop == stop2 && data == data2) return;
+    errors++;
+    printf("Not Passed: %s \"%s\": status %x/%x, stop %d/%d, result %d/%d\n", test, text,
+        stat, stat2, (int)(stop - text), (int)(stop2 - text), data, data2);
+}
+
+static void Compare(const char* test, _Tie& root, _Tie& memo_root, const char* text, bool memo_all)
+{
+    Gen u, m; const char* stop; const char* stop2;
+    Options opt, opt2; opt2.memo = memo_all? 1000: 0;
+    int stat = Analyze(root, text, &stop, u, 0, &opt);
+    int stat2 = Analyze(memo_root, text, &stop2, m, 0, &opt2);
+    Check(test, text, stat, stop, u.data, stat2, stop2, m.data);
+    bool same = opt.faults.size() == opt2.faults.size();
+    for (size_t i = 0; same && i < opt.faults.size(); i++)
+        same = opt.faults[i].start == opt2.faults[i].start && opt.faults[i].stop == opt2.faults[i].stop
+            && opt.faults[i].next == opt2.faults[i].next;
+    if (same) return;
+    errors++;
+    printf("Not Passed: %s \"%s\": faults %d/%d\n", test, text, (int)opt.faults.size(), (int)opt2.faults.size());
+}
+
+static void Calc(Rule& expr)
+{
+    Token digit('0', '9');
+    LEXEM(num) = 1*digit;
+    RULE(primary) = num | ("(" + expr + ")") | ("-" + primary);
+    RULE(mul) = primary + *(Token("*/%") + primary);
+    RULE(sum) = mul + *(Token("+-") + mul);
+    RULE(cmp) = sum + !(("<=" | Lexem(">=") | "<" | ">" | "==" | "!=") + sum);
+    expr = (cmp + *(Lexem("&&") + cmp)) | (sum + "?");
+    Bind(primary, DoSum); Bind(mul, DoSum); Bind(sum, DoSum); Bind(cmp, DoSum);
+}
+
+int main()
+{
+    Token key('a', 'z'), val('0', '9');
+    Rule rec = key + "=" + val + ";"; // the same rule is tried again at the end of its match
+    Rule plain = *rec;
+    Rule memo = key + "=" + val + ";"; memo.Memoize(); Rule memo_all = *memo;
+    const char* records[] = { "a=1; b=2; c=3;", "a=1;b=", "", "a=1;;b=2;" };
+    for (size_t i = 0; i < sizeof(records) / sizeof(records[0]); i++) {
+        Compare("Memoize()", plain, memo_all, records[i], false);
+        Compare("Options::memo", plain, plain, records[i], true); }
+
+    Rule bad = key + "=" + val + ";"; bad.Recover(";"); // bad records are skipped up to ';'
+    Rule bad_all = *bad;
+    Rule bad_memo = key + "=" + val + ";"; bad_memo.Recover(";"); bad_memo.Memoize();
+    Rule bad_memo_all = *bad_memo;
+    const char* faults[] = { "a=1; b==; c=3;", "a=1; b=; c", "x;; a=1;", "a=1; =2; b=2", ";;" };
+    for (size_t i = 0; i < sizeof(faults) / sizeof(faults[0]); i++) {
+        Compare("Recover() with Memoize()", bad_all, bad_memo_all, faults[i], false);
+        Compare("Recover() with Options::memo", bad_all, bad_all, faults[i], true); }
+
+    Rule expr; Calc(expr); Program program(expr);
+    const char alphabet[] = "0123456789+-*/%<>=!&?() ";
+    srand(1);
+    for (int i = 0; i < 20000; i++) {
+        char text[16]; int len = rand() % 15;
+        for (int k = 0; k < len; k++) text[k] = alphabet[rand() % (sizeof(alphabet) - 1)];
+        text[len] = 0;
+        Compare("Options::memo", expr, expr, text, true);
+        Compare("Program", expr, program, text, false);
+        Compare("Program with Options::memo", expr, program, text, true); }
+
+    printf("%s: %d errors\n", errors? "Not Passed": "Passed", errors);
+    return errors != 0;
+}